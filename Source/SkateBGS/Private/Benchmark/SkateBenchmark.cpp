@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Benchmark/SkateBenchmark.h"
+#include "HAL/MemoryBase.h"
+
+bool FSkateBenchmark::bActive = false;
+
+FSkateProbe::FSkateProbe(const TCHAR* InName)
+	: Name(InName)
+{
+	FSkateBenchmark::GetProbes().Add(this);
+}
+
+FSkateProbe::~FSkateProbe()
+{
+	FSkateBenchmark::GetProbes().Remove(this);
+}
+
+uint64 FSkateBenchmark::GetAllocCalls()
+{
+#if !UE_BUILD_SHIPPING
+	return (uint64)FMalloc::TotalMallocCalls + (uint64)FMalloc::TotalReallocCalls;
+#else
+	return 0;
+#endif
+}
+
+TArray<FSkateProbe*>& FSkateBenchmark::GetProbes()
+{
+	//Probes are statics in other translation units, so the list has to exist before the first of them
+	static TArray<FSkateProbe*> Probes;
+	return Probes;
+}
+
+void FSkateBenchmark::ResetCounters()
+{
+	for (FSkateProbe* Probe : GetProbes())
+	{
+		Probe->Cycles = 0;
+		Probe->Calls = 0;
+	}
+}
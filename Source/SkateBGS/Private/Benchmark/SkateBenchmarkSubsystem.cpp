@@ -0,0 +1,286 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Benchmark/SkateBenchmarkSubsystem.h"
+#include "Benchmark/SkateBenchmark.h"
+#include "Characters/SkateCharacter.h"
+#include "Objectives/RingCourse.h"
+#include "Objectives/RingManager.h"
+#include "SkateBGSLog.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "GameFramework/Controller.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+
+namespace
+{
+	constexpr int32 DefaultSkaters = 32;
+	constexpr int32 DefaultFrames = 600;
+	constexpr int32 DefaultRings = 256;
+
+	FAutoConsoleCommandWithWorldAndArgs SkateBenchmarkCommand(
+		TEXT("Skate.Benchmark"),
+		TEXT("Skate.Benchmark [Skaters] [Frames] [Rings]: runs the gameplay benchmark and writes a CSV to Saved/Profiling"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			USkateBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<USkateBenchmarkSubsystem>() : nullptr;
+			if (Benchmark)
+			{
+				Benchmark->StartBenchmark(
+					Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : DefaultSkaters,
+					Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : DefaultFrames,
+					Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : DefaultRings);
+			}
+		}));
+}
+
+bool USkateBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void USkateBenchmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("SkateBenchmark")))
+	{
+		int32 NumSkaters = DefaultSkaters;
+		int32 NumFrames = DefaultFrames;
+		int32 NumRings = DefaultRings;
+		FParse::Value(FCommandLine::Get(), TEXT("SkateBenchSkaters="), NumSkaters);
+		FParse::Value(FCommandLine::Get(), TEXT("SkateBenchFrames="), NumFrames);
+		FParse::Value(FCommandLine::Get(), TEXT("SkateBenchRings="), NumRings);
+
+		bExitWhenDone = true;
+		StartBenchmark(NumSkaters, NumFrames, NumRings);
+	}
+}
+
+TStatId USkateBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USkateBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void USkateBenchmarkSubsystem::StartBenchmark(int32 NumSkaters, int32 NumFrames, int32 NumRings)
+{
+	if (bRunning) return;
+
+	UE_LOG(LogSkateBGS, Display, TEXT("Skate benchmark: %d skaters, %d frames, %d rings"), NumSkaters, NumFrames, NumRings);
+
+	SpawnSkaters(FMath::Max(1, NumSkaters));
+	SpawnRingCourse(FMath::Max(0, NumRings));
+
+	Frame = 0;
+	FramesToRun = FMath::Max(1, NumFrames);
+
+	//Numbers are kept per frame and only formatted when the run finishes
+	const int32 NumProbes = FSkateBenchmark::GetProbes().Num();
+	Rows.Reset(FramesToRun);
+	ProbeCycles.Reset(FramesToRun * NumProbes);
+	ProbeCalls.Reset(FramesToRun * NumProbes);
+	LastFrameTime = FPlatformTime::Seconds();
+	LastAllocCalls = FSkateBenchmark::GetAllocCalls();
+	FSkateBenchmark::ResetCounters();
+	FSkateBenchmark::bActive = true;
+	bRunning = true;
+}
+
+void USkateBenchmarkSubsystem::SpawnSkaters(int32 NumSkaters)
+{
+	UWorld* World = GetWorld();
+	UClass* Class = SkaterClass.LoadSynchronous();
+	if (!Class)
+	{
+		Class = ASkateCharacter::StaticClass();
+	}
+
+	//Square grid, far enough apart that skaters don't collide during the run
+	const int32 Columns = FMath::CeilToInt32(FMath::Sqrt((float)NumSkaters));
+	const float Spacing = 400.f;
+
+	for (int32 Index = 0; Index < NumSkaters; ++Index)
+	{
+		const FTransform Transform(FVector((Index % Columns) * Spacing, (Index / Columns) * Spacing, 200.f));
+		ASkateCharacter* Skater = World->SpawnActorDeferred<ASkateCharacter>(Class, Transform, nullptr, nullptr,
+			ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+		if (Skater)
+		{
+			//No HUD, countdown or victory screen, only the gameplay tick is measured
+			Skater->bCreateHUD = false;
+			Skater->bIsBot = true;
+			Skater->FinishSpawning(Transform);
+			Skater->SpawnDefaultController();
+			Skaters.Add(Skater);
+		}
+	}
+}
+
+void USkateBenchmarkSubsystem::SpawnRingCourse(int32 NumRings)
+{
+	if (NumRings == 0) return;
+
+	URingCourse* Course = NewObject<URingCourse>(this);
+	Course->Rings.Reserve(NumRings);
+	const float Radius = 200.f * NumRings / PI;
+	for (int32 Index = 0; Index < NumRings; ++Index)
+	{
+		const float Angle = 2.f * PI * Index / NumRings;
+		FRingCourseEntry& Entry = Course->Rings.AddDefaulted_GetRef();
+		Entry.Location = FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 150.f);
+		Entry.Rotation = FRotator(0.f, FMath::RadiansToDegrees(Angle), 0.f);
+		Entry.TimeOffset = Index * 0.1f;
+	}
+
+	RingManager = GetWorld()->SpawnActorDeferred<ARingManager>(ARingManager::StaticClass(), FTransform::Identity);
+	if (RingManager)
+	{
+		RingManager->Course = Course;
+		RingManager->FinishSpawning(FTransform::Identity);
+	}
+}
+
+void USkateBenchmarkSubsystem::DriveSkaters()
+{
+	//Steady push with weaving and a boost every other two seconds, offset per skater
+	for (int32 Index = 0; Index < Skaters.Num(); ++Index)
+	{
+		ASkateCharacter* Skater = Skaters[Index];
+		if (!Skater) continue;
+
+		const float Steer = FMath::Sin(Frame * 0.02f + Index);
+		Skater->ScriptedMove(FVector2D(Steer, 1.f));
+
+		if ((Frame + Index * 7) % 240 == 0)
+		{
+			Skater->ScriptedSpeed(true);
+		}
+		else if ((Frame + Index * 7) % 240 == 120)
+		{
+			Skater->ScriptedSpeed(false);
+		}
+	}
+}
+
+void USkateBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	RecordFrame(Now - LastFrameTime);
+	LastFrameTime = Now;
+
+	Frame += 1;
+	if (Frame >= FramesToRun)
+	{
+		FinishBenchmark();
+		return;
+	}
+
+	DriveSkaters();
+}
+
+void USkateBenchmarkSubsystem::RecordFrame(double FrameSeconds)
+{
+	//The buffers are reserved for the whole run, so recording doesn't show up in the next frame's allocations
+	FSkateBenchmarkRow& Row = Rows.AddDefaulted_GetRef();
+	Row.FrameMs = FrameSeconds * 1000.0;
+	Row.Allocs = FSkateBenchmark::GetAllocCalls() - LastAllocCalls;
+	for (const FSkateProbe* Probe : FSkateBenchmark::GetProbes())
+	{
+		ProbeCycles.Add(Probe->Cycles);
+		ProbeCalls.Add(Probe->Calls);
+	}
+
+	for (const ASkateCharacter* Skater : Skaters)
+	{
+		if (Skater)
+		{
+			Row.TraceQueries += Skater->GetTraceQueries().GetFrameQueries();
+			Row.TickAllocs += Skater->GetTickAllocations();
+		}
+	}
+
+	LastAllocCalls = FSkateBenchmark::GetAllocCalls();
+
+	FSkateBenchmark::ResetCounters();
+}
+
+void USkateBenchmarkSubsystem::FinishBenchmark()
+{
+	bRunning = false;
+	FSkateBenchmark::bActive = false;
+
+	const FString Csv = FormatCsv();
+	Rows.Empty();
+	ProbeCycles.Empty();
+	ProbeCalls.Empty();
+
+	const FString FileName = FPaths::ProfilingDir() / FString::Printf(TEXT("SkateBenchmark-%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Csv, *FileName))
+	{
+		UE_LOG(LogSkateBGS, Display, TEXT("Skate benchmark finished, wrote %s"), *FileName);
+		LastCsvPath = FileName;
+	}
+	else
+	{
+		UE_LOG(LogSkateBGS, Error, TEXT("Skate benchmark could not write %s"), *FileName);
+		LastCsvPath.Empty();
+	}
+
+	DestroySpawnedActors();
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+FString USkateBenchmarkSubsystem::FormatCsv() const
+{
+	const TArray<FSkateProbe*>& Probes = FSkateBenchmark::GetProbes();
+
+	TStringBuilder<1024> Text;
+	Text << TEXT("Frame,FrameMs");
+	for (const FSkateProbe* Probe : Probes)
+	{
+		Text.Appendf(TEXT(",%s Ms,%s Calls"), Probe->Name, Probe->Name);
+	}
+	Text << TEXT(",TraceQueries,TickAllocs,Allocs\n");
+
+	for (int32 RowIndex = 0; RowIndex < Rows.Num(); ++RowIndex)
+	{
+		const FSkateBenchmarkRow& Row = Rows[RowIndex];
+		Text.Appendf(TEXT("%d,%.3f"), RowIndex, Row.FrameMs);
+		for (int32 ProbeIndex = 0; ProbeIndex < Probes.Num(); ++ProbeIndex)
+		{
+			const int32 Sample = RowIndex * Probes.Num() + ProbeIndex;
+			Text.Appendf(TEXT(",%.3f,%u"), FPlatformTime::ToMilliseconds64(ProbeCycles[Sample]), ProbeCalls[Sample]);
+		}
+		Text.Appendf(TEXT(",%d,%u,%llu\n"), Row.TraceQueries, Row.TickAllocs, Row.Allocs);
+	}
+	return FString(Text.ToView());
+}
+
+void USkateBenchmarkSubsystem::DestroySpawnedActors()
+{
+	for (ASkateCharacter* Skater : Skaters)
+	{
+		if (!IsValid(Skater)) continue;
+
+		if (AController* Controller = Skater->GetController())
+		{
+			Controller->Destroy();
+		}
+		Skater->Destroy();
+	}
+	Skaters.Reset();
+
+	if (IsValid(RingManager))
+	{
+		RingManager->Destroy();
+	}
+	RingManager = nullptr;
+}
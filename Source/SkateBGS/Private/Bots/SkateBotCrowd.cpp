@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Bots/SkateBotCrowd.h"
+#include "Characters/SkateCharacter.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+namespace
+{
+	const FVector BotProbeUp(0.f, 0.f, 200.f);
+	const FVector BotProbeDown(0.f, 0.f, 500.f);
+
+	constexpr int32 MaxBotStepsPerFrame = 4;
+
+	//Scale given to the instances of promoted bots so the full actor takes their place
+	const FVector HiddenInstanceScale(0.f);
+}
+
+ASkateBotCrowd::ASkateBotCrowd()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	BotInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("BotInstances"));
+	BotInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	BotInstances->SetCastShadow(false);
+	RootComponent = BotInstances;
+
+	ProbeDelegate.BindUObject(this, &ASkateBotCrowd::OnProbeDone);
+}
+
+void ASkateBotCrowd::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (SkaterClass)
+	{
+		SimParams = SkaterClass->GetDefaultObject<ASkateCharacter>()->GetSimParams();
+	}
+	Random.Initialize(RandomSeed);
+	TraceQueries.Init(this, TraceTypeQuery1);
+
+	SpawnBots();
+}
+
+void ASkateBotCrowd::SpawnBots()
+{
+	Locations.SetNumUninitialized(NumBots);
+	Yaws.SetNumUninitialized(NumBots);
+	Speeds.Init(0.f, NumBots);
+	GroundZ.SetNumUninitialized(NumBots);
+	SlopeZ.Init(0.f, NumBots);
+	MoveAxes.Init(FVector2D::ZeroVector, NumBots);
+	NextWanderTimes.Init(0.f, NumBots);
+	States.Init(SkateSim::MakeInitialState(SimParams), NumBots);
+	Promoted.Init(INDEX_NONE, NumBots);
+
+	const FVector Origin = GetActorLocation();
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(NumBots);
+	for (int32 Bot = 0; Bot < NumBots; ++Bot)
+	{
+		const FVector2D Offset = FVector2D(Random.VRand()).GetSafeNormal() * Radius * FMath::Sqrt(Random.FRand());
+		Locations[Bot] = Origin + FVector(Offset, 0.f);
+		GroundZ[Bot] = Origin.Z - GroundOffset;
+		Yaws[Bot] = Random.FRandRange(-180.f, 180.f);
+		Transforms.Add(FTransform(FRotator(0.f, Yaws[Bot], 0.f), Locations[Bot]));
+	}
+
+	BotInstances->ClearInstances();
+	BotInstances->AddInstances(Transforms, false, true);
+}
+
+void ASkateBotCrowd::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	TraceQueries.BeginFrame();
+
+	StepBots(DeltaTime);
+	RequestProbes();
+	UpdatePromotion();
+
+	//Instances are only drawn, a server keeps the bots as data
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		UpdateInstances();
+	}
+}
+
+void ASkateBotCrowd::Wander(int32 Bot, float Time)
+{
+	if (Time < NextWanderTimes[Bot]) return;
+	NextWanderTimes[Bot] = Time + Random.FRandRange(1.f, 4.f);
+
+	//Steer back towards the middle once outside the radius
+	float Turn = Random.FRandRange(-0.4f, 0.4f);
+	const FVector ToCenter = GetActorLocation() - Locations[Bot];
+	if (ToCenter.SizeSquared2D() > FMath::Square(Radius))
+	{
+		const FVector Forward = FRotator(0.f, Yaws[Bot], 0.f).Vector();
+		Turn = FVector::CrossProduct(Forward, ToCenter).Z > 0.f ? 1.f : -1.f;
+	}
+	MoveAxes[Bot] = FVector2D(Turn, Random.FRand() < 0.85f ? 1.f : 0.f);
+
+	//Boost now and then, the same way a player would
+	if (MoveAxes[Bot].Y > 0.f && States[Bot].Stamina >= SimParams.MaxStamina && Random.FRand() < 0.3f)
+	{
+		SkateSim::StartBoost(States[Bot], SimParams);
+	}
+	else
+	{
+		SkateSim::StopBoost(States[Bot]);
+	}
+}
+
+void ASkateBotCrowd::StepBots(float DeltaTime)
+{
+	const float Time = GetWorld()->GetTimeSeconds();
+	const float Step = SimParams.FixedTimeStep;
+
+	SimAccumulator = FMath::Min(SimAccumulator + DeltaTime, Step * MaxBotStepsPerFrame);
+	int32 NumSteps = 0;
+	while (SimAccumulator >= Step - KINDA_SMALL_NUMBER)
+	{
+		SimAccumulator -= Step;
+		NumSteps += 1;
+	}
+	if (NumSteps == 0) return;
+
+	for (int32 Bot = 0; Bot < Locations.Num(); ++Bot)
+	{
+		if (Promoted[Bot] != INDEX_NONE) continue;
+
+		Wander(Bot, Time);
+
+		FSkateSimInput Input;
+		Input.MoveAxis = MoveAxes[Bot];
+		Input.SlopeZ = SlopeZ[Bot];
+
+		FSkateSimState& State = States[Bot];
+		for (int32 StepIndex = 0; StepIndex < NumSteps; ++StepIndex)
+		{
+			Input.Speed = FMath::Abs(Speeds[Bot]);
+			Yaws[Bot] += SkateSim::Step(State, SimParams, Input);
+			SkateSim::StepBoost(State, SimParams, Input.Speed, Step);
+
+			//Stand in for the character movement component: accelerate towards the pushed speed
+			const float TargetSpeed = State.ForwardScale * State.MaxWalkSpeed;
+			Speeds[Bot] = FMath::FInterpConstantTo(Speeds[Bot], TargetSpeed, Step, MaxAcceleration);
+		}
+
+		const FVector Forward = FRotator(0.f, Yaws[Bot], 0.f).Vector();
+		FVector& Location = Locations[Bot];
+		Location += Forward * Speeds[Bot] * Step * NumSteps;
+		Location.Z = FMath::FInterpTo(Location.Z, GroundZ[Bot] + GroundOffset, Step * NumSteps, 15.f);
+	}
+}
+
+void ASkateBotCrowd::RequestProbes()
+{
+	UWorld* World = GetWorld();
+	const int32 NumProbes = FMath::Min(ProbesPerFrame, Locations.Num());
+
+	//Round robin over the bots, the results land before next frame's step
+	for (int32 Count = 0; Count < NumProbes; ++Count)
+	{
+		const int32 Bot = NextProbe;
+		NextProbe = (NextProbe + 1) % Locations.Num();
+		if (Promoted[Bot] != INDEX_NONE) continue;
+
+		const FVector Ground(Locations[Bot].X, Locations[Bot].Y, GroundZ[Bot]);
+		TraceQueries.AsyncLineTrace(World, Ground + BotProbeUp, Ground - BotProbeDown, &ProbeDelegate, Bot);
+	}
+}
+
+void ASkateBotCrowd::OnProbeDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const int32 Bot = Datum.UserData;
+	if (!GroundZ.IsValidIndex(Bot) || Datum.OutHits.Num() == 0 || !Datum.OutHits[0].bBlockingHit) return;
+
+	const FHitResult& Hit = Datum.OutHits[0];
+	GroundZ[Bot] = Hit.ImpactPoint.Z;
+
+	//Z of the board's forward vector along the ground, what the sim pushes back against uphill
+	const FVector Forward = FRotator(0.f, Yaws[Bot], 0.f).Vector();
+	SlopeZ[Bot] = FVector::VectorPlaneProject(Forward, Hit.ImpactNormal).GetSafeNormal().Z;
+}
+
+void ASkateBotCrowd::UpdatePromotion()
+{
+	if (!SkaterClass) return;
+
+	const APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player) return;
+	const FVector PlayerLocation = Player->GetActorLocation();
+
+	for (int32 Slot = PromotedActors.Num() - 1; Slot >= 0; --Slot)
+	{
+		const ASkateCharacter* Skater = PromotedActors[Slot];
+		if (!Skater || FVector::DistSquared(Skater->GetActorLocation(), PlayerLocation) > FMath::Square(DemoteDistance))
+		{
+			Demote(Slot);
+		}
+	}
+
+	for (int32 Bot = 0; Bot < Locations.Num() && PromotedActors.Num() < MaxPromoted; ++Bot)
+	{
+		if (Promoted[Bot] == INDEX_NONE && FVector::DistSquared(Locations[Bot], PlayerLocation) < FMath::Square(PromoteDistance))
+		{
+			Promote(Bot);
+		}
+	}
+
+	//Promoted bots keep following their wander input through the character's own handlers
+	const float Time = GetWorld()->GetTimeSeconds();
+	for (int32 Slot = 0; Slot < PromotedActors.Num(); ++Slot)
+	{
+		const int32 Bot = PromotedBots[Slot];
+		Wander(Bot, Time);
+		PromotedActors[Slot]->ScriptedMove(MoveAxes[Bot]);
+	}
+}
+
+void ASkateBotCrowd::Promote(int32 Bot)
+{
+	const FVector Location = Locations[Bot];
+	const FRotator Rotation(0.f, Yaws[Bot], 0.f);
+
+	ASkateCharacter* Skater = IdleActors.Num() > 0 ? IdleActors.Pop(false) : nullptr;
+	if (Skater)
+	{
+		Skater->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Skater->SetActorHiddenInGame(false);
+		Skater->SetActorEnableCollision(true);
+		Skater->Revive();
+		Skater->SetActorTickEnabled(true);
+		Skater->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		SpawnParams.bDeferConstruction = true;
+		Skater = GetWorld()->SpawnActor<ASkateCharacter>(SkaterClass, Location, Rotation, SpawnParams);
+		if (!Skater) return;
+
+		Skater->bCreateHUD = false;
+		Skater->bIsBot = true;
+		Skater->FinishSpawning(FTransform(Rotation, Location));
+		Skater->SpawnDefaultController();
+	}
+
+	Skater->GetCharacterMovement()->Velocity = Rotation.Vector() * Speeds[Bot];
+	Promoted[Bot] = PromotedActors.Add(Skater);
+	PromotedBots.Add(Bot);
+}
+
+void ASkateBotCrowd::Demote(int32 Slot)
+{
+	const int32 Bot = PromotedBots[Slot];
+	ASkateCharacter* Skater = PromotedActors[Slot];
+	if (Skater)
+	{
+		//Carry on from where the full skater ended up
+		Locations[Bot] = Skater->GetActorLocation();
+		GroundZ[Bot] = Locations[Bot].Z - GroundOffset;
+		Yaws[Bot] = Skater->GetActorRotation().Yaw;
+		Speeds[Bot] = Skater->GetVelocity().Size2D();
+
+		Skater->ScriptedMove(FVector2D::ZeroVector);
+		Skater->GetCharacterMovement()->StopMovementImmediately();
+		Skater->GetCharacterMovement()->DisableMovement();
+		Skater->SetActorTickEnabled(false);
+		Skater->GetWorldTimerManager().ClearAllTimersForObject(Skater);
+		Skater->SetActorEnableCollision(false);
+		Skater->SetActorHiddenInGame(true);
+		IdleActors.Add(Skater);
+	}
+
+	Promoted[Bot] = INDEX_NONE;
+	PromotedActors.RemoveAtSwap(Slot, 1, false);
+	PromotedBots.RemoveAtSwap(Slot, 1, false);
+	if (PromotedBots.IsValidIndex(Slot))
+	{
+		Promoted[PromotedBots[Slot]] = Slot;
+	}
+}
+
+void ASkateBotCrowd::UpdateInstances()
+{
+	InstanceTransforms.SetNumUninitialized(Locations.Num(), false);
+	for (int32 Bot = 0; Bot < Locations.Num(); ++Bot)
+	{
+		InstanceTransforms[Bot] = Promoted[Bot] == INDEX_NONE
+			? FTransform(FRotator(0.f, Yaws[Bot], 0.f), Locations[Bot])
+			: FTransform(FQuat::Identity, Locations[Bot], HiddenInstanceScale);
+	}
+	BotInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
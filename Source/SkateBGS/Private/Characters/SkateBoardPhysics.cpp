@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateBoardPhysics.h"
+#include "Chaos/SimCallbackObject.h"
+#include "Components/PrimitiveComponent.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+struct FSkateBoardAsyncInput : public Chaos::FSimCallbackInput
+{
+	Chaos::FSingleParticlePhysicsProxy* Proxy = nullptr;
+	FSkateBoardTuning Tuning;
+	FVector2D MoveAxis = FVector2D::ZeroVector;
+	bool bBoost = false;
+	int32 JumpCount = 0;
+	FVector ContactLocations[USkateBoardPhysics::NumWheels];
+	FVector ContactNormals[USkateBoardPhysics::NumWheels];
+	uint8 ContactMask = 0;
+
+	void Reset()
+	{
+		Proxy = nullptr;
+		ContactMask = 0;
+	}
+};
+
+struct FSkateBoardAsyncOutput : public Chaos::FSimCallbackOutput
+{
+	uint8 GroundedMask = 0;
+	FVector FloorNormal = FVector::UpVector;
+
+	void Reset()
+	{
+		GroundedMask = 0;
+		FloorNormal = FVector::UpVector;
+	}
+};
+
+class FSkateBoardCallback : public Chaos::TSimCallbackObject<FSkateBoardAsyncInput, FSkateBoardAsyncOutput>
+{
+	virtual void OnPreSimulate_Internal() override;
+
+	//Physics thread only, the game thread's input can be consumed by several steps
+	int32 LastJumpCount = 0;
+};
+
+void FSkateBoardCallback::OnPreSimulate_Internal()
+{
+	const FSkateBoardAsyncInput* Input = GetConsumerInput_Internal();
+	if (!Input || !Input->Proxy)
+	{
+		return;
+	}
+	Chaos::FRigidBodyHandle_Internal* Board = Input->Proxy->GetPhysicsThreadAPI();
+	if (!Board)
+	{
+		return;
+	}
+
+	const FSkateBoardTuning& Tuning = Input->Tuning;
+	const FVector Position = Board->X();
+	const FQuat Rotation = Board->R();
+	const FVector Velocity = Board->V();
+	const FVector AngularVelocity = Board->W();
+	const float Mass = Board->M();
+	const float Inertia = Board->I().GetMax();
+	const FVector Up = Rotation.GetUpVector();
+
+	FVector Force = FVector::ZeroVector;
+	FVector Torque = FVector::ZeroVector;
+	FVector NormalSum = FVector::ZeroVector;
+	uint8 GroundedMask = 0;
+
+	for (int32 Wheel = 0; Wheel < USkateBoardPhysics::NumWheels; ++Wheel)
+	{
+		if (!(Input->ContactMask & (1 << Wheel)))
+		{
+			continue;
+		}
+
+		//Wheel ray down the board against the contact plane, skip planes the ray runs along
+		const FVector Arm = Rotation.RotateVector(Tuning.WheelOffsets[Wheel]);
+		const FVector Mount = Position + Arm;
+		const FVector& Normal = Input->ContactNormals[Wheel];
+		const float Approach = FVector::DotProduct(-Up, Normal);
+		if (Approach < 0.1f)
+		{
+			continue;
+		}
+		const float Distance = FMath::Max(FVector::DotProduct(Mount - Input->ContactLocations[Wheel], Normal) / Approach, 0.f);
+		if (Distance > Tuning.SuspensionLength)
+		{
+			continue;
+		}
+
+		const FVector PointVelocity = Velocity + FVector::CrossProduct(AngularVelocity, Arm);
+		const float Compression = Tuning.SuspensionLength - Distance;
+		const float SpringAcceleration = FMath::Max(Tuning.SpringStiffness * Compression - Tuning.SpringDamping * FVector::DotProduct(PointVelocity, Up), 0.f);
+		FVector WheelForce = Up * SpringAcceleration;
+
+		const FVector Lateral = FVector::VectorPlaneProject(Rotation.GetRightVector(), Normal).GetSafeNormal();
+		WheelForce -= Lateral * FVector::DotProduct(PointVelocity, Lateral) * Tuning.LateralGrip;
+
+		WheelForce *= Mass / USkateBoardPhysics::NumWheels;
+		Force += WheelForce;
+		Torque += FVector::CrossProduct(Arm, WheelForce);
+		NormalSum += Normal;
+		GroundedMask |= 1 << Wheel;
+	}
+
+	FSkateBoardAsyncOutput& Output = GetProducerOutputData_Internal();
+	Output.GroundedMask = GroundedMask;
+
+	if (GroundedMask)
+	{
+		const FVector FloorNormal = NormalSum.GetSafeNormal();
+		const FVector Along = FVector::VectorPlaneProject(Rotation.GetForwardVector(), FloorNormal).GetSafeNormal();
+		const float ForwardSpeed = FVector::DotProduct(Velocity, Along);
+		const float MaxSpeed = Input->bBoost ? Tuning.MaxBoostSpeed : Tuning.MaxPushSpeed;
+		const float Push = ForwardSpeed < MaxSpeed ? FMath::Clamp(Input->MoveAxis.Y, 0.f, 1.f) * (Input->bBoost ? Tuning.BoostAcceleration : Tuning.PushAcceleration) : 0.f;
+		Force += Along * (Push - ForwardSpeed * Tuning.RollingDrag) * Mass;
+
+		//Steer by driving the yaw rate around the floor normal, grip turns the velocity with the board
+		const float YawRate = FVector::DotProduct(AngularVelocity, FloorNormal);
+		const float TargetYawRate = FMath::DegreesToRadians(Tuning.TurnRate) * Input->MoveAxis.X;
+		Torque += FloorNormal * (TargetYawRate - YawRate) * Tuning.SteerResponse * Inertia;
+
+		if (Input->JumpCount != LastJumpCount)
+		{
+			Board->SetV(Velocity + FloorNormal * Tuning.JumpSpeed);
+		}
+		Output.FloorNormal = FloorNormal;
+	}
+	else
+	{
+		Torque -= AngularVelocity * Tuning.AirAngularDamping * Inertia;
+	}
+
+	//Jumps asked for in the air are dropped rather than fired on landing
+	LastJumpCount = Input->JumpCount;
+
+	Board->AddForce(Force);
+	Board->AddTorque(Torque);
+}
+
+USkateBoardPhysics::USkateBoardPhysics()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void USkateBoardPhysics::StartSimulating(UPrimitiveComponent* InBody)
+{
+	UWorld* World = GetWorld();
+	FPhysScene* Scene = World ? World->GetPhysicsScene() : nullptr;
+	if (Callback || !InBody || !Scene)
+	{
+		return;
+	}
+
+	InBody->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	InBody->SetSimulatePhysics(true);
+	Body = InBody;
+	Callback = Scene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FSkateBoardCallback>();
+}
+
+void USkateBoardPhysics::StopSimulating()
+{
+	if (!Callback)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	if (FPhysScene* Scene = World ? World->GetPhysicsScene() : nullptr)
+	{
+		Scene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(Callback);
+	}
+	Callback = nullptr;
+	GroundedMask = 0;
+}
+
+void USkateBoardPhysics::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopSimulating();
+	Super::EndPlay(EndPlayReason);
+}
+
+void USkateBoardPhysics::SetMoveInput(const FVector2D& InMoveAxis, bool bInBoost)
+{
+	MoveAxis = InMoveAxis;
+	bBoost = bInBoost;
+}
+
+void USkateBoardPhysics::SetWheelContact(int32 Wheel, const FVector& Location, const FVector& Normal)
+{
+	ContactLocations[Wheel] = Location;
+	ContactNormals[Wheel] = Normal;
+	ContactMask |= 1 << Wheel;
+}
+
+void USkateBoardPhysics::ClearWheelContact(int32 Wheel)
+{
+	ContactMask &= ~(1 << Wheel);
+}
+
+FVector USkateBoardPhysics::GetWheelLocation(int32 Wheel) const
+{
+	const UPrimitiveComponent* BodyComponent = Body.Get();
+	return BodyComponent ? BodyComponent->GetComponentTransform().TransformPosition(Tuning.WheelOffsets[Wheel]) : FVector::ZeroVector;
+}
+
+void USkateBoardPhysics::ExchangeWithPhysics()
+{
+	UPrimitiveComponent* BodyComponent = Body.Get();
+	if (!Callback || !BodyComponent)
+	{
+		return;
+	}
+
+	if (FSkateBoardAsyncInput* Input = Callback->GetProducerInputData_External())
+	{
+		Input->Proxy = BodyComponent->GetBodyInstance() ? BodyComponent->GetBodyInstance()->GetPhysicsActorHandle() : nullptr;
+		Input->Tuning = Tuning;
+		Input->MoveAxis = MoveAxis;
+		Input->bBoost = bBoost;
+		Input->JumpCount = JumpCount;
+		Input->ContactMask = ContactMask;
+		for (int32 Wheel = 0; Wheel < NumWheels; ++Wheel)
+		{
+			Input->ContactLocations[Wheel] = ContactLocations[Wheel];
+			Input->ContactNormals[Wheel] = ContactNormals[Wheel];
+		}
+	}
+
+	//Only steps up to the interpolated transform, so the contacts match the body we show
+	while (Chaos::TSimCallbackOutputHandle<FSkateBoardAsyncOutput> Output = Callback->PopOutputData_External())
+	{
+		GroundedMask = Output->GroundedMask;
+		FloorNormal = Output->FloorNormal;
+	}
+}
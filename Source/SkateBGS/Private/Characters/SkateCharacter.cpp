@@ -10,13 +10,54 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "UI/CharacterUI.h"
+#include "Characters/SkateInputRecorder.h"
+#include "Characters/SkateMovementComponent.h"
+#include "Ghost/SkateGhost.h"
+#include "Misc/Paths.h"
 #include "Kismet/GameplayStatics.h"
+#include "Effects/SkateEffectsSubsystem.h"
+#include "Game/SkateLoadingSubsystem.h"
+#include "Characters/SkateGroundField.h"
+#include "Characters/SkateBoardPhysics.h"
+#include "Components/SphereComponent.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "SkateBGSLog.h"
+#include "SkateBGSStats.h"
+
+DECLARE_SKATE_CYCLE_STAT(TEXT("Character Tick"), STAT_SkateCharacterTick);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Move"), STAT_SkateMove);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Align Skate"), STAT_SkateAlignSkate);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Trace Floor"), STAT_SkateTraceFloor);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Trace Collision"), STAT_SkateTraceCollision);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Update Camera"), STAT_SkateUpdateCamera);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Step Simulation"), STAT_SkateStepSimulation);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Physics Movement"), STAT_SkatePhysicsMovement);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Player Speed"), STAT_SkatePlayerSpeed, STATGROUP_SkateBGS);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Player Stamina"), STAT_SkatePlayerStamina, STATGROUP_SkateBGS);
+
+TRACE_DECLARE_FLOAT_COUNTER(SkatePlayerSpeed, TEXT("SkateBGS/Player Speed"));
+TRACE_DECLARE_FLOAT_COUNTER(SkatePlayerStamina, TEXT("SkateBGS/Player Stamina"));
+TRACE_DECLARE_INT_COUNTER(SkatePlayerTraces, TEXT("SkateBGS/Player Traces"));
+
+namespace
+{
+	const FName FloorProbeSockets[] = { FName("ForwardSocket"), FName("BackwardSocket"), FName("LeftWheel"), FName("RightWheel") };
+	const FVector FloorProbeUp(0.f, 0.f, 20.f);
+	const FVector FloorProbeDown(0.f, 0.f, 50.f);
+
+	//Wheel contacts of the physics board look further, the suspension reaches below the mounts
+	const FVector WheelProbeUp(0.f, 0.f, 50.f);
+	const FVector WheelProbeDown(0.f, 0.f, 100.f);
+
+	//Frames longer than this drop simulation time instead of running a burst of steps
+	constexpr int32 MaxSimStepsPerFrame = 8;
+}
 
 // Sets default values
-ASkateCharacter::ASkateCharacter()
+ASkateCharacter::ASkateCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USkateMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	//Code From the default Unreal Character
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
@@ -38,12 +79,18 @@ ASkateCharacter::ASkateCharacter()
 	SkateMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("SkateMesh"));
 	SkateMesh->SetupAttachment(RootComponent);
 
-	//Sphere = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Sphere"));
-	//Sphere->SetupAttachment(RootComponent);
-	//Sphere->SetHiddenInGame(true);
-	//Sphere->SetSimulatePhysics(true);
-	//Sphere->SetCollisionResponseToAllChannels(ECR_Ignore);
-	//Sphere->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+	InputRecorder = CreateDefaultSubobject<USkateInputRecorder>(TEXT("InputRecorder"));
+
+	Sphere = CreateDefaultSubobject<USphereComponent>(TEXT("Sphere"));
+	Sphere->SetupAttachment(RootComponent);
+	Sphere->SetRelativeLocation(FVector(0.f, 0.f, -60.f));
+	Sphere->InitSphereRadius(15.f);
+	Sphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Sphere->SetCollisionResponseToAllChannels(ECR_Ignore);
+	Sphere->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+	Sphere->SetCollisionResponseToChannel(ECC_WorldDynamic, ECR_Block);
+
+	BoardPhysics = CreateDefaultSubobject<USkateBoardPhysics>(TEXT("BoardPhysics"));
 
 	if (GetCharacterMovement())
 	{
@@ -56,6 +103,7 @@ ASkateCharacter::ASkateCharacter()
 		GetMesh()->SetCollisionProfileName(FName("Ragdoll"));
 	}
 
+	FloorProbeDelegate.BindUObject(this, &ASkateCharacter::OnFloorProbeDone);
 }
 
 // Called when the game starts or when spawned
@@ -72,60 +120,132 @@ void ASkateCharacter::BeginPlay()
 		}
 	}
 
-	Stamina = MaxStamina;
+	SimState = SkateSim::MakeInitialState(GetSimParams());
+	SyncFromSimState();
+	TraceQueries.Init(this, TraceTypeQuery1);
+	GroundField = Cast<ASkateGroundField>(UGameplayStatics::GetActorOfClass(this, ASkateGroundField::StaticClass()));
+
+	ValidatePhysicsMovement();
 
-	if (GetWorld())
+	if (bUsePhysicsMovement && Sphere && BoardPhysics)
 	{
-		APlayerController* Controller2 = GetWorld()->GetFirstPlayerController();
-		if (Controller2 && HUDClass)
-		{
-			HUD = CreateWidget<UCharacterUI>(Controller2, HUDClass);
-			HUD->AddToViewport();
-			HUD->UpdateRingCount(RingCounter);
-		}
+		GetCharacterMovement()->DisableMovement();
+		PhysicsBodyOffset = Sphere->GetRelativeLocation();
+		Sphere->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		BoardPhysics->StartSimulating(Sphere);
 	}
-	GetWorldTimerManager().SetTimer(TimerHandle, this, &ASkateCharacter::CountDown, 1.f, true, 0.f);
+
+	if (USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>())
+	{
+		Effects->Prewarm(DeathSound, 1);
+	}
+
+	//Nobody sees the pose on a server, montages still tick for their notifies and root motion
+	if (!HasPresentation() && GetMesh())
+	{
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+	}
+	RunStartTime = GetWorld()->GetTimeSeconds();
 	
 }
 
+void ASkateCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GhostWriter.Discard();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASkateCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	//Runs on possession on the server and when the controller replicates on clients. Only the local player's own skater
+	//records input, has a HUD and counts down, on the machine that player is on
+	if (bIsBot || !IsLocallyControlled() || !IsPlayerControlled()) return;
+
+	if (InputRecorder)
+	{
+		InputRecorder->Arm();
+	}
+
+#if !UE_SERVER
+	if (!HUD && bCreateHUD && HUDClass && HasPresentation())
+	{
+		HUD = CreateWidget<UCharacterUI>(Cast<APlayerController>(Controller), HUDClass);
+		HUD->AddToViewport();
+		HUD->UpdateRingCount(RingCounter);
+	}
+#endif
+
+	if (!GetWorldTimerManager().TimerExists(TimerHandle) && !bHasWon)
+	{
+		GetWorldTimerManager().SetTimer(TimerHandle, this, &ASkateCharacter::CountDown, 1.f, true, 0.f);
+	}
+}
+
 // Called every frame
 void ASkateCharacter::Tick(float DeltaTime)
 {
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateCharacterTick);
+	FSkateAllocScope AllocScope(TickAllocations);
 	Super::Tick(DeltaTime);
-	//SetPhysicsMovement();
+	TraceQueries.BeginFrame();
 
 	TraceCollision();
-	if (!bIsHoldingMoveAxis)
+	if (bUsePhysicsMovement)
 	{
-		Move(FVector2D(0.f, 0.f));
-		//MovePhysics(FVector2D(0.f, 0.f));
+		SetPhysicsMovement(DeltaTime);
 	}
+	else
+	{
+		if (!bIsHoldingMoveAxis)
+		{
+			Move(FVector2D(0.f, 0.f));
+		}
+		StepSimulation(DeltaTime);
+	}
+	RecordGhostFrame();
 
-	if (bCanFlipSkate)
+	if (!bReportedControllable && IsPlayerControlled() && IsLocallyControlled())
+	{
+		bReportedControllable = true;
+		if (USkateLoadingSubsystem* Loading = UGameInstance::GetSubsystem<USkateLoadingSubsystem>(GetGameInstance()))
+		{
+			Loading->NotifyPlayerControllable();
+		}
+	}
+
+	if (bCanFlipSkate && HasPresentation())
 	{
 		FlipSkate();
 	}
 
-	if (GetCharacterMovement())
+	if (GetCharacterMovement() && HasPresentation())
 	{
 		const float Speed = GetVelocity().Size();
 
-		UpdateCamera(Speed);
+		UpdateCamera(Speed, DeltaTime);
 
-		if (!GetCharacterMovement()->IsFalling())
+		//The physics board's body already carries the skate's tilt
+		if (!bUsePhysicsMovement && !GetCharacterMovement()->IsFalling())
 		{
-			AlignSkate();
+			AlignSkate(DeltaTime);
 		}
+	}
 
-		if (Speed > RegularSpeed && !bIsSpeedingUp)
-		{
-			GetCharacterMovement()->MaxWalkSpeed = FMath::Lerp(GetCharacterMovement()->MaxWalkSpeed, RegularSpeed, Friction / DecelerationRate);
-		}
-		if (Speed < RegularSpeed - 100 && GetCharacterMovement()->MaxWalkSpeed > RegularSpeed && !bIsSpeedingUp)
-		{
-			GetCharacterMovement()->MaxWalkSpeed = RegularSpeed;
-		}
+	//Counters follow the player's skater, bots and ghosts would overwrite each other
+	if (IsPlayerControlled())
+	{
+		const float Speed = GetVelocity().Size();
+		SET_FLOAT_STAT(STAT_SkatePlayerSpeed, Speed);
+		SET_FLOAT_STAT(STAT_SkatePlayerStamina, Stamina);
+		TRACE_COUNTER_SET(SkatePlayerSpeed, Speed);
+		TRACE_COUNTER_SET(SkatePlayerStamina, Stamina);
+		TRACE_COUNTER_SET(SkatePlayerTraces, TraceQueries.GetFrameQueries());
 	}
+
+	UpdateTickInterval();
 }
 
 void ASkateCharacter::CountDown()
@@ -148,28 +268,81 @@ void ASkateCharacter::CountDown()
 		}
 	}
 
-	HUD->UpdateTimer(Minutes, Seconds);
+	if (HUD)
+	{
+		HUD->UpdateTimer(Minutes, Seconds);
+	}
+
+}
 
+FString ASkateCharacter::GetGhostPath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("Ghosts") / UGameplayStatics::GetCurrentLevelName(this) + TEXT(".ghost");
+}
+
+void ASkateCharacter::StartGhostRun()
+{
+	//Only the local player's run is recorded, and only once it is possessed
+	bGhostRunStarted = true;
+	const FString Path = GetGhostPath();
+
+	if (GhostClass)
+	{
+		ASkateGhost* Ghost = GetWorld()->SpawnActor<ASkateGhost>(GhostClass, GetActorTransform());
+		if (Ghost && !Ghost->StartPlayback(Path))
+		{
+			Ghost->Destroy();
+		}
+	}
+
+	if (bRecordGhost)
+	{
+		GhostWriter.Begin(Path);
+	}
+}
+
+void ASkateCharacter::RecordGhostFrame()
+{
+	if (!bGhostRunStarted && IsLocallyControlled() && IsPlayerControlled())
+	{
+		StartGhostRun();
+	}
+	if (!GhostWriter.IsRecording()) return;
+
+	FGhostFrame Frame;
+	Frame.Time = GetWorld()->GetTimeSeconds() - RunStartTime;
+	Frame.Location = GetActorLocation();
+	Frame.Rotation = GetActorRotation();
+	Frame.SkateRotation = SkateMesh ? SkateMesh->GetRelativeRotation() : FRotator::ZeroRotator;
+	Frame.Speed = GetVelocity().Size();
+	Frame.bIsFalling = GetCharacterMovement() && GetCharacterMovement()->IsFalling();
+	Frame.bIsSpeedingUp = bIsSpeedingUp;
+	Frame.bIsFlipping = bCanFlipSkate;
+	GhostWriter.AddFrame(Frame);
 }
 
 void ASkateCharacter::StopAllActions()
 {
+	GhostWriter.Discard();
 	GetWorldTimerManager().ClearTimer(TimerHandle);
 	ForwardAxis = 0.f;
 	RightAxis = 0.f;
 	SlowDown();
 }
 
-void ASkateCharacter::UpdateCamera(const float& Speed)
+void ASkateCharacter::UpdateCamera(const float& Speed, float DeltaTime)
 {
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateUpdateCamera);
 	if (!GetCharacterMovement()->IsFalling())
 	{
 		float FOV = FMath::Clamp(Speed / 11.f, 90.f, 105.f);
-		CameraFOV = FMath::Lerp(CameraFOV, FOV, 0.05f);
+		//Eases by 5% per 60 Hz frame, at any frame rate
+		const float Alpha = SkateSim::GetDecayAlpha(0.05f, DeltaTime);
+		CameraFOV = FMath::Lerp(CameraFOV, FOV, Alpha);
 		FollowCamera->SetFieldOfView(CameraFOV);
 
 		float Length = FMath::Clamp(Speed / 3.5f, 300.f, 325.f);
-		ArmLength = FMath::Lerp(ArmLength, Length, 0.05f);
+		ArmLength = FMath::Lerp(ArmLength, Length, Alpha);
 		CameraBoom->TargetArmLength = ArmLength;
 	}
 }
@@ -191,54 +364,142 @@ void ASkateCharacter::Look(const FInputActionValue& Value)
 
 void ASkateCharacter::Move(const FInputActionValue& Value)
 {
-	// input is a Vector2D
-	FVector2D MovementVector = Value.Get<FVector2D>();
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateMove);
+	// input is a Vector2D, the simulation step consumes it in Tick
+	const FVector2D MovementVector = Value.Get<FVector2D>();
 	ForwardAxis = MovementVector.Y;
 	RightAxis = MovementVector.X;
-	MovementVector.Y = FMath::Clamp(MovementVector.Y, 0, 1);
-	const float CurrentSpeed = GetVelocity().Size();
+}
 
-	if (Controller != nullptr)
+FSkateSimParams ASkateCharacter::GetSimParams() const
+{
+	FSkateSimParams Params;
+	Params.RegularSpeed = RegularSpeed;
+	Params.MaxSpeed = MaxSpeed;
+	Params.MaxStamina = MaxStamina;
+	Params.StaminaDrainPerSecond = StaminaDrainPerSecond;
+	Params.StaminaRegenPerSecond = StaminaRegenPerSecond;
+	Params.TurnRate = TurnRate;
+	Params.Friction = Friction;
+	Params.DecelerationRate = DecelerationRate;
+	return Params;
+}
+
+FSkateSimInput ASkateCharacter::MakeSimInput() const
+{
+	FSkateSimInput Input;
+	Input.MoveAxis = FVector2D(RightAxis, ForwardAxis);
+	Input.Speed = GetVelocity().Size();
+	Input.SlopeZ = SkateMesh ? SkateMesh->GetForwardVector().Z : 0.f;
+	Input.bIsFalling = GetCharacterMovement() && GetCharacterMovement()->IsFalling();
+	return Input;
+}
+
+void ASkateCharacter::UpdateTickInterval()
+{
+	//Skaters ticking their own movement input stay at the frame rate, the movement component consumes it every frame
+	float Interval = 0.f;
+	if (!IsLocallyControlled())
 	{
-		// add movement
-		float DecelerationScale = GetDecelerationScale(CurrentSpeed);
-		float ZForward = 0.f;
-		if (!GetCharacterMovement()->IsFalling())
+		Interval = RemoteTickInterval;
+		const APlayerController* Viewer = GetWorld()->GetFirstPlayerController();
+		if (HasPresentation() && Viewer && Viewer->PlayerCameraManager)
 		{
-			ZForward = FMath::Clamp(SkateMesh->GetForwardVector().Z * 3, -0.8f, 0.8f);
+			const float ViewDistanceSquared = FVector::DistSquared(Viewer->PlayerCameraManager->GetCameraLocation(), GetActorLocation());
+			if (ViewDistanceSquared < FMath::Square(RemoteFullTickDistance))
+			{
+				Interval = 0.f;
+			}
 		}
-		ForwardScaleValue = FMath::Lerp(ForwardScaleValue, MovementVector.Y - ZForward, Friction * DecelerationScale);
-		AddMovementInput(GetActorForwardVector(), ForwardScaleValue);
-		//RightScaleValue = FMath::Lerp(RightScaleValue, MovementVector.X, 0.02f);
+	}
 
-		//add rotation
-		const float TurnPercent = TurnRate / GetCharacterMovement()->MaxWalkSpeed;
-		const float NewYawRotation = MovementVector.X * FMath::Clamp(CurrentSpeed * TurnPercent, 0.25f, 1000000000.f);
-		AddActorWorldRotation(FRotator(0.f, NewYawRotation, 0.f));
+	if (GetActorTickInterval() != Interval)
+	{
+		SetActorTickInterval(Interval);
 	}
 }
 
-void ASkateCharacter::MoveTrigger(const FInputActionValue& Value)
+bool ASkateCharacter::HasPresentation() const
 {
-	bIsHoldingMoveAxis = true;
-	if (bIsHoldingSpeed)
+#if UE_SERVER
+	return false;
+#else
+	return !IsNetMode(NM_DedicatedServer);
+#endif
+}
+
+USkateMovementComponent* ASkateCharacter::GetSkateMovement() const
+{
+	return Cast<USkateMovementComponent>(GetCharacterMovement());
+}
+
+void ASkateCharacter::StepSimulation(float DeltaTime)
+{
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateStepSimulation);
+	const FSkateSimParams Params = GetSimParams();
+	const FSkateSimInput Input = MakeSimInput();
+	const bool bWasSpeedingUp = SimState.bIsSpeedingUp;
+
+	//Boost and top speed are stepped by the movement component inside predicted moves
+	if (const USkateMovementComponent* Movement = GetSkateMovement())
 	{
-		SpeedUp();
+		SimState.bIsSpeedingUp = Movement->IsBoosting();
+		SimState.Stamina = Movement->GetStamina();
+		SimState.MaxWalkSpeed = Movement->MaxWalkSpeed;
+	}
+	if (!bWasSpeedingUp && SimState.bIsSpeedingUp)
+	{
+		SkateSim::ApplyBoostPush(SimState, Params, Input.Speed);
+	}
+
+	SimAccumulator = FMath::Min(SimAccumulator + DeltaTime, Params.FixedTimeStep * MaxSimStepsPerFrame);
+	while (SimAccumulator >= Params.FixedTimeStep - KINDA_SMALL_NUMBER)
+	{
+		SkateSim::Step(SimState, Params, Input);
+		SimAccumulator -= Params.FixedTimeStep;
+	}
+
+	//The turn is applied every frame at the same rate per second, above 60 Hz some frames don't run a step
+	const float TurnTime = FMath::Min(DeltaTime, Params.FixedTimeStep * MaxSimStepsPerFrame);
+	const float Yaw = SkateSim::GetTurn(SimState, Params, Input) * TurnTime / Params.FixedTimeStep;
+
+	//Ran out of stamina, the component keeps the boost off until the button is pressed again
+	if (bWasSpeedingUp && !SimState.bIsSpeedingUp)
+	{
+		bIsHoldingSpeed = false;
+	}
+
+	if (Controller != nullptr)
+	{
+		AddMovementInput(GetActorForwardVector(), SimState.ForwardScale);
+		AddActorWorldRotation(FRotator(0.f, Yaw, 0.f));
+	}
+	SyncFromSimState();
+}
+
+void ASkateCharacter::SyncFromSimState()
+{
+	ForwardScaleValue = SimState.ForwardScale;
+	bIsSpeedingUp = SimState.bIsSpeedingUp;
+	Stamina = SimState.Stamina;
+
+	//Only push to the HUD when the bar would visibly change
+	const int32 Percent = FMath::RoundToInt(Stamina / MaxStamina * 100.f);
+	if (HUD && Percent != DisplayedStaminaPercent)
+	{
+		DisplayedStaminaPercent = Percent;
+		HUD->SetStaminaPercent(Percent / 100.f);
 	}
-	Move(Value);
-	//MovePhysics(Value);
 }
 
-float ASkateCharacter::GetDecelerationScale(float CurrentSpeed)
+void ASkateCharacter::MoveTrigger(const FInputActionValue& Value)
 {
-	float DecelerationScale = 1.f;
-	if (CurrentSpeed > 400.f && ForwardAxis == 0)
+	bIsHoldingMoveAxis = true;
+	if (bIsHoldingSpeed)
 	{
-		float DecMultiplier = CurrentSpeed >= RegularSpeed + 100.f ? CurrentSpeed / 30.f : 1.f;
-		DecelerationScale /= DecelerationRate * DecMultiplier;
-		return DecelerationScale;
+		SpeedUp();
 	}
-	return 1.f;
+	Move(Value);
 }
 
 void ASkateCharacter::ReleaseTrigger()
@@ -266,56 +527,36 @@ void ASkateCharacter::SpeedTrigger()
 
 void ASkateCharacter::SpeedUp()
 {
-	if (!GetCharacterMovement()->IsFalling() && ForwardAxis > 0)
+	if (bUsePhysicsMovement)
 	{
-		bIsSpeedingUp = true;
 		bIsHoldingSpeed = false;
-		if (GetVelocity().Size() < RegularSpeed && ForwardScaleValue > .9f)
-		{
-			ForwardScaleValue -= 0.2f;
-		}
-		GetCharacterMovement()->MaxWalkSpeed = MaxSpeed;
-
-		if (GetWorldTimerManager().IsTimerActive(StaminaRegenTimer))
-		{
-			GetWorldTimerManager().ClearTimer(StaminaRegenTimer);
-		}
-		GetWorldTimerManager().SetTimer(StaminaDrainTimer, this, &ASkateCharacter::DrainStamina, 0.016f, true, 0.f);
+		SimState.bIsSpeedingUp = true;
+		SyncFromSimState();
+		return;
 	}
-}
-
-void ASkateCharacter::SlowDown()
-{
-	bIsSpeedingUp = false;
-	bIsHoldingSpeed = false;
 
-	if (GetWorldTimerManager().IsTimerActive(StaminaDrainTimer))
+	USkateMovementComponent* Movement = GetSkateMovement();
+	if (Movement && SkateSim::CanStartBoost(MakeSimInput()))
 	{
-		GetWorldTimerManager().ClearTimer(StaminaDrainTimer);
+		bIsHoldingSpeed = false;
+		Movement->SetWantsToBoost(true);
 	}
-
-	GetWorldTimerManager().SetTimer(StaminaRegenTimer, this, &ASkateCharacter::RegenStamina, 0.016f, true, 0.f);
 }
 
-void ASkateCharacter::DrainStamina()
+void ASkateCharacter::SlowDown()
 {
-	Stamina = FMath::Clamp(Stamina - StaminaDrainRate, 0.f, MaxStamina);
-	if (HUD)
+	if (USkateMovementComponent* Movement = GetSkateMovement())
 	{
-		HUD->SetStaminaPercent(Stamina / MaxStamina);
+		Movement->SetWantsToBoost(false);
 	}
-	if (Stamina <= 0.f)
+	bIsHoldingSpeed = false;
+	if (bUsePhysicsMovement)
 	{
-		SlowDown();
+		SimState.bIsSpeedingUp = false;
+		SyncFromSimState();
 	}
 }
 
-void ASkateCharacter::RegenStamina()
-{
-	Stamina = FMath::Clamp(Stamina + StaminaDrainRate / 2, 0.f, MaxStamina);
-	HUD->SetStaminaPercent(Stamina / MaxStamina);
-}
-
 void ASkateCharacter::StartJump()
 {
 	bCanFlipSkate = true;
@@ -327,21 +568,58 @@ void ASkateCharacter::StartJump()
 
 void ASkateCharacter::CollectRing()
 {
+	RingCounter += 1;
 	if (HUD)
 	{
-		RingCounter += 1;
 		HUD->UpdateRingCount(RingCounter);
 	}
 
-	if (RingCounter >= 33)
+	if (RingCounter >= 33 && !bIsBot)
 	{
 		GetWorldTimerManager().ClearTimer(TimerHandle);
-		ShowVictoryScreen();
+		GhostWriter.Finish(GetWorld()->GetTimeSeconds() - RunStartTime);
+		if (IsLocallyControlled())
+		{
+			ShowVictoryScreen();
+		}
 		bHasWon = true;
 	}
 	RingCollected.Broadcast();
 }
 
+void ASkateCharacter::ResetRingCount()
+{
+	RingCounter = 0;
+	if (HUD)
+	{
+		HUD->UpdateRingCount(RingCounter);
+	}
+}
+
+void ASkateCharacter::ScriptedMove(const FVector2D& MoveAxis)
+{
+	if (MoveAxis.IsZero())
+	{
+		ReleaseTrigger();
+	}
+	else
+	{
+		MoveTrigger(FInputActionValue(MoveAxis));
+	}
+}
+
+void ASkateCharacter::ScriptedSpeed(bool bPressed)
+{
+	if (bPressed)
+	{
+		SpeedTrigger();
+	}
+	else
+	{
+		SlowDown();
+	}
+}
+
 void ASkateCharacter::EndJump()
 {
 	bCanFlipSkate = false;
@@ -353,6 +631,19 @@ void ASkateCharacter::EndJump()
 
 void ASkateCharacter::Jump()
 {
+	if (bUsePhysicsMovement)
+	{
+		if (BoardPhysics && BoardPhysics->IsGrounded())
+		{
+			if (JumpMontage)
+			{
+				PlayAnimMontage(JumpMontage, 1.f, FName("Jump"));
+			}
+			BoardPhysics->RequestJump();
+		}
+		return;
+	}
+
 	if (!GetCharacterMovement()->IsFalling())
 	{
 		if (JumpMontage)
@@ -371,37 +662,79 @@ void ASkateCharacter::FlipSkate()
 	}
 }
 
-void ASkateCharacter::AlignSkate()
+void ASkateCharacter::AlignSkate(float DeltaTime)
 {
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateAlignSkate);
 	if (SkateMesh)
 	{
+		FVector Origins[NumFloorProbes];
+		for (int32 Index = 0; Index < NumFloorProbes; ++Index)
+		{
+			Origins[Index] = SkateMesh->GetSocketLocation(FloorProbeSockets[Index]);
+		}
+
+		//Use last frame's probe batch when it is complete, trace synchronously otherwise (e.g. right after landing)
+		FVector Locations[NumFloorProbes];
+		if (!SampleGroundField(Origins, Locations))
+		{
+			if (!bUseAsyncFloorProbes || !ConsumeFloorProbes(Locations))
+			{
+				for (int32 Index = 0; Index < NumFloorProbes; ++Index)
+				{
+					Locations[Index] = TraceFloor(Origins[Index]);
+				}
+			}
+
+			if (bUseAsyncFloorProbes)
+			{
+				RequestFloorProbes(Origins);
+			}
+		}
+
 		//Trace the floor to align Vertical Skate orientation
-		const FVector ForwardLocation = TraceFloor(SkateMesh->GetSocketLocation(FName("ForwardSocket")));
-		const FVector BackwardLocation = TraceFloor(SkateMesh->GetSocketLocation(FName("BackwardSocket")));
-		const FRotator NewRotationV = UKismetMathLibrary::FindLookAtRotation(BackwardLocation, ForwardLocation);
+		const FRotator NewRotationV = UKismetMathLibrary::FindLookAtRotation(Locations[1], Locations[0]);
 
 		//Trace the floor to align Horizontal Skate orientation
-		const FVector LeftLocation = TraceFloor(SkateMesh->GetSocketLocation(FName("LeftWheel")));
-		const FVector RightLocation = TraceFloor(SkateMesh->GetSocketLocation(FName("RightWheel")));
-		const FRotator NewRotationH = UKismetMathLibrary::FindLookAtRotation(RightLocation, LeftLocation);
+		const FRotator NewRotationH = UKismetMathLibrary::FindLookAtRotation(Locations[3], Locations[2]);
+
+		//Yaw comes from this frame's sockets so async results from the previous frame don't lag when turning
+		const float Yaw = UKismetMathLibrary::FindLookAtRotation(Origins[1], Origins[0]).Yaw;
 
-		const FRotator NewRotation(NewRotationV.Pitch, NewRotationV.Yaw, NewRotationH.Pitch);
-		FRotator TargetRotation = FMath::RInterpTo(SkateMesh->GetComponentRotation(), NewRotation, GetWorld()->GetDeltaSeconds(), 20.f);
+		const FRotator NewRotation(NewRotationV.Pitch, Yaw, NewRotationH.Pitch);
+		//A third of the way per 60 Hz frame, DeltaTime covers the whole interval when the tick is throttled
+		const FQuat TargetRotation = FQuat::Slerp(SkateMesh->GetComponentQuat(), NewRotation.Quaternion(), SkateSim::GetDecayAlpha(1.f / 3.f, DeltaTime));
 		SkateMesh->SetWorldRotation(TargetRotation);
 
 	}
 }
 
+bool ASkateCharacter::SampleGroundField(const FVector* Origins, FVector* OutLocations) const
+{
+	const ASkateGroundField* Field = GroundField.Get();
+	if (!Field)
+	{
+		return false;
+	}
+
+	//All four or none, a half baked board would mix this frame's heights with last frame's probes
+	for (int32 Index = 0; Index < NumFloorProbes; ++Index)
+	{
+		if (!Field->SampleFloor(Origins[Index], FloorProbeUp.Z, FloorProbeDown.Z, OutLocations[Index]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 FVector ASkateCharacter::TraceFloor(const FVector Origin)
 {
-	const FVector TraceStart = Origin + FVector(0.f, 0.f, 20.f);
-	const FVector TraceEnd = Origin - FVector(0.f, 0.f, 50.f);
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateTraceFloor);
+	const FVector TraceStart = Origin + FloorProbeUp;
+	const FVector TraceEnd = Origin - FloorProbeDown;
 
 	FHitResult HitResult;
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(this);
-	UKismetSystemLibrary::LineTraceSingle(GetWorld(), TraceStart, TraceEnd, TraceTypeQuery1,
-		false, ActorsToIgnore, EDrawDebugTrace::None, HitResult, true);
+	TraceQueries.LineTrace(GetWorld(), TraceStart, TraceEnd, HitResult);
 
 	if (HitResult.bBlockingHit)
 	{
@@ -410,19 +743,89 @@ FVector ASkateCharacter::TraceFloor(const FVector Origin)
 	return Origin;
 }
 
+void ASkateCharacter::RequestFloorProbes(const FVector* Origins)
+{
+	UWorld* World = GetWorld();
+	if (!World) return;
+
+	FloorProbeBatch += 1;
+	FloorProbeMask = 0;
+	bFloorProbesPending = true;
+
+	//UserData carries the batch in the high bits and the probe index in the low two bits
+	for (int32 Index = 0; Index < NumFloorProbes; ++Index)
+	{
+		FloorProbeResults[Index] = Origins[Index];
+		TraceQueries.AsyncLineTrace(World, Origins[Index] + FloorProbeUp, Origins[Index] - FloorProbeDown, &FloorProbeDelegate, (FloorProbeBatch << 2) | Index);
+	}
+}
+
+void ASkateCharacter::OnFloorProbeDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	if ((Datum.UserData >> 2) != (FloorProbeBatch & (MAX_uint32 >> 2))) return;
+
+	const int32 Index = Datum.UserData & 3;
+	if (Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+	{
+		FloorProbeResults[Index] = Datum.OutHits[0].Location;
+	}
+	FloorProbeMask |= 1 << Index;
+}
+
+bool ASkateCharacter::ConsumeFloorProbes(FVector* OutLocations)
+{
+	const bool bComplete = bFloorProbesPending && FloorProbeMask == (1 << NumFloorProbes) - 1;
+	bFloorProbesPending = false;
+	if (!bComplete) return false;
+
+	for (int32 Index = 0; Index < NumFloorProbes; ++Index)
+	{
+		OutLocations[Index] = FloorProbeResults[Index];
+	}
+	return true;
+}
+
+void ASkateCharacter::Landed(const FHitResult& Hit)
+{
+	Super::Landed(Hit);
+
+	//Probes submitted before leaving the ground are stale, the first grounded frame traces synchronously
+	bFloorProbesPending = false;
+	FloorProbeMask = 0;
+}
+
 void ASkateCharacter::TraceCollision()
 {
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateTraceCollision);
+
+	//Below crash speed no hit can kill, and the movement sweep reports actual impacts through OnSkateImpact.
+	//Above it this looks a little ahead so the board doesn't clip into the wall before the crash.
+	if (bHasWon || bIsDead || GetVelocity().Size() <= CrashSpeed) return;
+
 	FVector TraceStart = GetActorLocation();
 	FVector TraceEnd = GetActorForwardVector() * 35.f;
 	TraceEnd += TraceStart;
 
 	FHitResult HitResult;
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(this);
-	UKismetSystemLibrary::BoxTraceSingle(GetWorld(), TraceStart, TraceEnd, FVector(0.f, 20.f, 60.f), GetActorRotation(), TraceTypeQuery1,
-		false, ActorsToIgnore, EDrawDebugTrace::None, HitResult, true);
+	TraceQueries.BoxSweep(GetWorld(), TraceStart, TraceEnd, GetActorQuat(), FVector(0.f, 20.f, 60.f), HitResult);
 
-	if (!bHasWon && HitResult.bBlockingHit && GetVelocity().Size() > 750.f)
+	//Same rules as an actual impact, ramps and glancing walls ahead don't end the run
+	if (HitResult.bBlockingHit)
+	{
+		OnSkateImpact(HitResult, GetVelocity());
+	}
+}
+
+void ASkateCharacter::OnSkateImpact(const FHitResult& Hit, const FVector& ImpactVelocity)
+{
+	if (bHasWon || bIsDead) return;
+
+	//Floors and ramps the skater can ride onto are never a crash
+	if (GetCharacterMovement() && GetCharacterMovement()->IsWalkable(Hit)) return;
+
+	//Only the part of the velocity going into the wall counts, grinding along it is fine
+	const float ImpactSpeed = -FVector::DotProduct(ImpactVelocity, Hit.ImpactNormal);
+	if (ImpactSpeed > CrashSpeed)
 	{
 		Die();
 	}
@@ -430,8 +833,14 @@ void ASkateCharacter::TraceCollision()
 
 void ASkateCharacter::Die()
 {
+	if (bIsDead) return;
+	bIsDead = true;
+
 	StopAllActions();
-	CallResetMenu();
+	if (!bIsBot)
+	{
+		CallResetMenu();
+	}
 
 	if (GetMesh() && SkateMesh)
 	{
@@ -442,73 +851,132 @@ void ASkateCharacter::Die()
 	{
 		GetCharacterMovement()->StopMovementImmediately();
 	}
-	if (DeathSound)
+	if (BoardPhysics)
+	{
+		BoardPhysics->StopSimulating();
+	}
+	if (USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>())
 	{
-		UGameplayStatics::SpawnSoundAtLocation(GetWorld(), DeathSound, GetActorLocation());
+		Effects->PlaySound(DeathSound, GetActorLocation());
 	}
 	PrimaryActorTick.bCanEverTick = false;
 }
 
-void ASkateCharacter::MovePhysics(const FInputActionValue& Value)
+void ASkateCharacter::ValidatePhysicsMovement()
 {
-	FVector2D MovementVector = Value.Get<FVector2D>();
-	ForwardAxis = MovementVector.Y;
-	RightAxis = MovementVector.X;
-	MovementVector.Y = FMath::Clamp(MovementVector.Y, 0, 1);
-	const float CurrentSpeed = GetVelocity().Size();
+	//The board body is simulated locally only: no predicted boost, no server corrections and no HandleImpact crashes
+	if (bUsePhysicsMovement && GetNetMode() != NM_Standalone)
+	{
+		UE_LOG(LogSkateBGS, Warning, TEXT("%s: physics movement only runs in standalone games, using the movement component"), *GetName());
+		bUsePhysicsMovement = false;
+	}
+	if (bUsePhysicsMovement && !UPhysicsSettings::Get()->bTickPhysicsAsync)
+	{
+		UE_LOG(LogSkateBGS, Display, TEXT("Physics movement steps with the frame, enable Tick Physics Async in the project's physics settings for fixed steps"));
+	}
+}
+
+void ASkateCharacter::Revive()
+{
+	if (!bIsDead) return;
+	bIsDead = false;
+
+	//Ragdolls leave their parent, put the meshes back where the class has them
+	const ASkateCharacter* Defaults = GetClass()->GetDefaultObject<ASkateCharacter>();
+	if (GetMesh() && SkateMesh)
+	{
+		GetMesh()->SetSimulatePhysics(false);
+		GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		GetMesh()->SetRelativeTransform(Defaults->GetMesh()->GetRelativeTransform());
+		SkateMesh->SetSimulatePhysics(false);
+		SkateMesh->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		SkateMesh->SetRelativeTransform(Defaults->SkateMesh->GetRelativeTransform());
+	}
 
-	Sphere->AddForce(GetActorForwardVector() * RegularSpeed * 110.f * MovementVector.Y);
+	SimState = SkateSim::MakeInitialState(GetSimParams());
+	SimAccumulator = 0.f;
+	SyncFromSimState();
+
+	//The body kept simulating on its own after the crash, bring it back under the skater at rest
+	if (bUsePhysicsMovement && Sphere && BoardPhysics)
+	{
+		Sphere->SetWorldLocationAndRotation(GetActorLocation() + GetActorQuat().RotateVector(PhysicsBodyOffset), GetActorQuat(), false, nullptr, ETeleportType::ResetPhysics);
+		Sphere->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		Sphere->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+		BoardPhysics->StartSimulating(Sphere);
+	}
+	PrimaryActorTick.bCanEverTick = true;
+	SetActorTickEnabled(true);
+}
 
-	float RotationSpeed = RegularSpeed * 1100.f * TurnRate * MovementVector.X;
-	Sphere->AddForce(GetActorRightVector() * RotationSpeed);
+FVector ASkateCharacter::GetVelocity() const
+{
+	if (bUsePhysicsMovement)
+	{
+		return GetSimulatedVelocity();
+	}
+	return Super::GetVelocity();
 }
 
-FVector ASkateCharacter::GetSimulatedVelocity()
+FVector ASkateCharacter::GetSimulatedVelocity() const
 {
 	if (!Sphere) return FVector(0.f, 0.f, 0.f);
 
 	return Sphere->GetPhysicsLinearVelocity();
 }
 
-FVector ASkateCharacter::GetFloorNormal(const FVector Origin)
+bool ASkateCharacter::TraceWheelContact(const FVector Origin, FVector& OutLocation, FVector& OutNormal)
 {
-	const FVector TraceStart = Origin;
-	const FVector TraceEnd = Origin - FVector(0.f, 0.f, 100.f);
+	if (GroundField.IsValid() && GroundField->SampleFloor(Origin, WheelProbeUp.Z, WheelProbeDown.Z, OutLocation, &OutNormal))
+	{
+		return true;
+	}
 
 	FHitResult HitResult;
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(this);
-	UKismetSystemLibrary::LineTraceSingle(GetWorld(), TraceStart, TraceEnd, TraceTypeQuery1,
-		false, ActorsToIgnore, EDrawDebugTrace::ForOneFrame, HitResult, true);
+	TraceQueries.LineTrace(GetWorld(), Origin + WheelProbeUp, Origin - WheelProbeDown, HitResult);
 
 	if (HitResult.bBlockingHit)
 	{
-		return HitResult.Normal;
+		OutLocation = HitResult.ImpactPoint;
+		OutNormal = HitResult.ImpactNormal;
+		return true;
 	}
-	return FVector(0.f, 0.f, 1.f);
+	return false;
 }
 
-void ASkateCharacter::SetPhysicsMovement()
+void ASkateCharacter::SetPhysicsMovement(float DeltaTime)
 {
-	if (Sphere && SkateMesh)
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkatePhysicsMovement);
+	if (!Sphere || !BoardPhysics || !BoardPhysics->IsSimulating())
 	{
-		SetActorLocation(Sphere->GetComponentLocation(), false, nullptr, ETeleportType::TeleportPhysics);
-		const FVector ForwardNormal = GetFloorNormal(SkateMesh->GetSocketLocation(FName("ForwardSocket")));
+		return;
+	}
 
-		FloorNormal = UKismetMathLibrary::VLerp(FloorNormal, ForwardNormal, 0.04f);
+	//The body's transform here is interpolated between physics steps, the actor just follows it
+	const FQuat BodyRotation = Sphere->GetComponentQuat();
+	SetActorLocationAndRotation(Sphere->GetComponentLocation() - BodyRotation.RotateVector(PhysicsBodyOffset), BodyRotation, false, nullptr, ETeleportType::TeleportPhysics);
 
-		if (GetSimulatedVelocity().Size() > 5.f)
+	for (int32 Wheel = 0; Wheel < USkateBoardPhysics::NumWheels; ++Wheel)
+	{
+		FVector Location;
+		FVector Normal;
+		if (TraceWheelContact(BoardPhysics->GetWheelLocation(Wheel), Location, Normal))
 		{
-			const FVector Velocity = GetSimulatedVelocity();
-			const float Speed = GetSimulatedVelocity().Size();
-			const FVector RightVector = UKismetMathLibrary::RotateAngleAxis(Velocity, 90.f, FloorNormal);
-
-			FRotator RotationFromAxes = UKismetMathLibrary::MakeRotationFromAxes(Velocity, RightVector, FloorNormal);
-
-			FRotator NewRotation = UKismetMathLibrary::RLerp(GetActorRotation(), RotationFromAxes, 0.1f, true);
-			SetActorRotation(NewRotation);
+			BoardPhysics->SetWheelContact(Wheel, Location, Normal);
+		}
+		else
+		{
+			BoardPhysics->ClearWheelContact(Wheel);
 		}
 	}
+
+	//Same boost rules as the movement component's, without its prediction
+	SkateSim::StepBoost(SimState, GetSimParams(), GetSimulatedVelocity().Size(), DeltaTime);
+	SyncFromSimState();
+
+	BoardPhysics->SetMoveInput(bIsHoldingMoveAxis ? FVector2D(RightAxis, ForwardAxis) : FVector2D::ZeroVector, bIsSpeedingUp);
+	BoardPhysics->ExchangeWithPhysics();
+	FloorNormal = BoardPhysics->GetFloorNormal();
 }
 
 // Called to bind functionality to input
@@ -533,6 +1001,11 @@ void ASkateCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComp
 
 		// Looking
 		EnhancedInputComponent->BindAction(LookAction, ETriggerEvent::Triggered, this, &ASkateCharacter::Look);
+
+		if (InputRecorder)
+		{
+			InputRecorder->BindInput(EnhancedInputComponent, MoveAction, LookAction, JumpAction, SpeedAction);
+		}
 	}
 	//////////////////////////////////////////////////////////////
 
@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateGroundField.h"
+#include "Components/BoxComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "SkateBGSLog.h"
+
+namespace
+{
+	//Heights at and above DynamicHeight are markers, not ground
+	constexpr uint16 EmptyHeight = 0xFFFF;
+	constexpr uint16 DynamicHeight = 0xFFFE;
+	constexpr float MaxStoredHeight = 0xFFFD;
+
+	struct FGroundSample
+	{
+		uint16 Height;
+		int8 NormalX;
+		int8 NormalY;
+	};
+	static_assert(sizeof(FGroundSample) == 4, "Ground samples are cooked as 4 bytes");
+
+	//Octahedral mapping keeps the normal error even over the sphere with two bytes
+	FVector2D OctWrap(const FVector2D& V)
+	{
+		return FVector2D((1.f - FMath::Abs(V.Y)) * (V.X >= 0.f ? 1.f : -1.f), (1.f - FMath::Abs(V.X)) * (V.Y >= 0.f ? 1.f : -1.f));
+	}
+
+	void EncodeNormal(const FVector& Normal, FGroundSample& Sample)
+	{
+		FVector2D Encoded = FVector2D(Normal.X, Normal.Y) / (FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z));
+		if (Normal.Z < 0.f)
+		{
+			Encoded = OctWrap(Encoded);
+		}
+		Sample.NormalX = (int8)FMath::RoundToInt(FMath::Clamp(Encoded.X, -1.f, 1.f) * 127.f);
+		Sample.NormalY = (int8)FMath::RoundToInt(FMath::Clamp(Encoded.Y, -1.f, 1.f) * 127.f);
+	}
+
+	FVector DecodeNormal(const FGroundSample& Sample)
+	{
+		FVector2D Encoded(Sample.NormalX / 127.f, Sample.NormalY / 127.f);
+		const float Z = 1.f - FMath::Abs(Encoded.X) - FMath::Abs(Encoded.Y);
+		if (Z < 0.f)
+		{
+			Encoded = OctWrap(Encoded);
+		}
+		return FVector(Encoded.X, Encoded.Y, Z).GetSafeNormal();
+	}
+}
+
+ASkateGroundField::ASkateGroundField()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Bounds = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds"));
+	Bounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Bounds->SetBoxExtent(FVector(5000.f, 5000.f, 1000.f));
+	Bounds->SetMobility(EComponentMobility::Static);
+	RootComponent = Bounds;
+
+#if WITH_EDITORONLY_DATA
+	//Every skater in the map reads it, it can't be streamed out under them
+	bIsSpatiallyLoaded = false;
+#endif
+}
+
+void ASkateGroundField::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	//Cooked samples go in their own payload so platforms that can map files don't copy them
+	if (Ar.IsCooking())
+	{
+		SampleData.SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload | BULKDATA_MemoryMappedPayload);
+	}
+	SampleData.Serialize(Ar, this, INDEX_NONE, true);
+}
+
+void ASkateGroundField::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const int64 ExpectedSize = (int64)NumStoredTiles * SamplesPerTile * sizeof(FGroundSample);
+	if (NumStoredTiles > 0 && SampleData.GetBulkDataSize() == ExpectedSize && TileOffsets.Num() == NumTilesX * NumTilesY)
+	{
+		Samples = static_cast<const uint8*>(SampleData.LockReadOnly());
+	}
+	else
+	{
+		UE_LOG(LogSkateBGS, Warning, TEXT("%s has no baked ground, skaters will trace the floor"), *GetName());
+	}
+}
+
+void ASkateGroundField::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Samples)
+	{
+		SampleData.Unlock();
+		Samples = nullptr;
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ASkateGroundField::SampleFloor(const FVector& Location, float Above, float Below, FVector& OutLocation, FVector* OutNormal) const
+{
+	if (!Samples)
+	{
+		return false;
+	}
+
+	const float GridX = (Location.X - Origin.X) / CellSize;
+	const float GridY = (Location.Y - Origin.Y) / CellSize;
+	if (GridX < 0.f || GridY < 0.f)
+	{
+		return false;
+	}
+
+	const int32 CellX = FMath::FloorToInt(GridX);
+	const int32 CellY = FMath::FloorToInt(GridY);
+	const int32 TileX = CellX / TileSize;
+	const int32 TileY = CellY / TileSize;
+	if (TileX >= NumTilesX || TileY >= NumTilesY)
+	{
+		return false;
+	}
+
+	const int32 Tile = TileOffsets[TileY * NumTilesX + TileX];
+	if (Tile == INDEX_NONE)
+	{
+		return false;
+	}
+
+	//The apron row and column hold the next tile's first samples, so the four corners are always in this tile
+	const FGroundSample* TileSamples = reinterpret_cast<const FGroundSample*>(Samples) + (int64)Tile * SamplesPerTile;
+	const FGroundSample* Corner = TileSamples + (CellY - TileY * TileSize) * TileStride + (CellX - TileX * TileSize);
+	const FGroundSample& S00 = Corner[0];
+	const FGroundSample& S10 = Corner[1];
+	const FGroundSample& S01 = Corner[TileStride];
+	const FGroundSample& S11 = Corner[TileStride + 1];
+
+	if (S00.Height >= DynamicHeight || S10.Height >= DynamicHeight || S01.Height >= DynamicHeight || S11.Height >= DynamicHeight)
+	{
+		return false;
+	}
+
+	//Ledges and curbs would be smoothed into ramps, let a trace find the real edge
+	const uint16 Lowest = FMath::Min(FMath::Min(S00.Height, S10.Height), FMath::Min(S01.Height, S11.Height));
+	const uint16 Highest = FMath::Max(FMath::Max(S00.Height, S10.Height), FMath::Max(S01.Height, S11.Height));
+	if ((Highest - Lowest) * HeightStep > MaxStepHeight)
+	{
+		return false;
+	}
+
+	const float AlphaX = GridX - CellX;
+	const float AlphaY = GridY - CellY;
+	const float Height = FMath::BiLerp((float)S00.Height, (float)S10.Height, (float)S01.Height, (float)S11.Height, AlphaX, AlphaY);
+	const float Z = MinZ + Height * HeightStep;
+
+	//Outside the probe window means the skater is airborne or under a bridge the field doesn't know about
+	if (Z > Location.Z + Above || Z < Location.Z - Below)
+	{
+		return false;
+	}
+
+	OutLocation = FVector(Location.X, Location.Y, Z);
+	if (OutNormal)
+	{
+		*OutNormal = FMath::BiLerp(DecodeNormal(S00), DecodeNormal(S10), DecodeNormal(S01), DecodeNormal(S11), AlphaX, AlphaY).GetSafeNormal();
+	}
+	return true;
+}
+
+#if WITH_EDITOR
+void ASkateGroundField::Bake()
+{
+	UWorld* World = GetWorld();
+	if (!World || !Bounds)
+	{
+		return;
+	}
+
+	const FBox Box = Bounds->Bounds.GetBox();
+	const int32 NumCellsX = FMath::Max(1, FMath::CeilToInt(Box.GetSize().X / CellSize));
+	const int32 NumCellsY = FMath::Max(1, FMath::CeilToInt(Box.GetSize().Y / CellSize));
+
+	Modify();
+	Origin = FVector2D(Box.Min.X, Box.Min.Y);
+	NumTilesX = FMath::DivideAndRoundUp(NumCellsX, TileSize);
+	NumTilesY = FMath::DivideAndRoundUp(NumCellsY, TileSize);
+	MinZ = Box.Min.Z;
+	HeightStep = FMath::Max(Box.GetSize().Z / MaxStoredHeight, KINDA_SMALL_NUMBER);
+	TileOffsets.Init(INDEX_NONE, NumTilesX * NumTilesY);
+	NumStoredTiles = 0;
+
+	//Same channel and shape as the skate's floor probes so the field agrees with the trace fallback
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(SkateGroundFieldBake), false, this);
+	for (TActorIterator<APawn> It(World); It; ++It)
+	{
+		Params.AddIgnoredActor(*It);
+	}
+
+	TArray<FGroundSample> Baked;
+	TArray<FGroundSample> TileSamples;
+	TileSamples.SetNumUninitialized(SamplesPerTile);
+	int32 NumDynamic = 0;
+
+	for (int32 TileY = 0; TileY < NumTilesY; ++TileY)
+	{
+		for (int32 TileX = 0; TileX < NumTilesX; ++TileX)
+		{
+			bool bHasGround = false;
+			for (int32 Y = 0; Y < TileStride; ++Y)
+			{
+				for (int32 X = 0; X < TileStride; ++X)
+				{
+					const FVector2D Point = Origin + FVector2D(TileX * TileSize + X, TileY * TileSize + Y) * CellSize;
+					FGroundSample& Sample = TileSamples[Y * TileStride + X];
+					Sample = { EmptyHeight, 0, 0 };
+
+					FHitResult Hit;
+					if (!World->LineTraceSingleByChannel(Hit, FVector(Point, Box.Max.Z), FVector(Point, Box.Min.Z), ECC_Visibility, Params))
+					{
+						continue;
+					}
+
+					bHasGround = true;
+					const UPrimitiveComponent* HitComponent = Hit.GetComponent();
+					if (!HitComponent || HitComponent->Mobility != EComponentMobility::Static)
+					{
+						Sample.Height = DynamicHeight;
+						++NumDynamic;
+						continue;
+					}
+
+					Sample.Height = (uint16)FMath::Clamp(FMath::RoundToInt((Hit.Location.Z - MinZ) / HeightStep), 0, (int32)MaxStoredHeight);
+					EncodeNormal(Hit.ImpactNormal, Sample);
+				}
+			}
+
+			if (bHasGround)
+			{
+				TileOffsets[TileY * NumTilesX + TileX] = NumStoredTiles++;
+				Baked.Append(TileSamples);
+			}
+		}
+	}
+
+	const int64 NumBytes = Baked.Num() * sizeof(FGroundSample);
+	SampleData.Lock(LOCK_READ_WRITE);
+	FMemory::Memcpy(SampleData.Realloc(NumBytes), Baked.GetData(), NumBytes);
+	SampleData.Unlock();
+
+	MarkPackageDirty();
+	UE_LOG(LogSkateBGS, Log, TEXT("%s baked %d of %d tiles (%lld KB), %d samples left to traces over movable objects"),
+		*GetName(), NumStoredTiles, NumTilesX * NumTilesY, NumBytes / 1024, NumDynamic);
+}
+#endif
@@ -0,0 +1,357 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateInputRecorder.h"
+#include "Characters/SkateCharacter.h"
+#include "SkateBGSLog.h"
+#include "EnhancedInputComponent.h"
+#include "InputActionValue.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	constexpr uint32 RecordingMagic = 0x4E494B53; // "SKIN"
+	constexpr uint16 RecordingVersion = 1;
+
+	FString ResolveRecordingPath(const FString& Path)
+	{
+		return FPaths::IsRelative(Path) ? FPaths::ProjectSavedDir() / TEXT("InputRecordings") / Path : Path;
+	}
+}
+
+USkateInputRecorder::USkateInputRecorder()
+{
+	//Ticks only while recording or replaying, before the character so replayed input lands in the same frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void USkateInputRecorder::Arm()
+{
+	if (Mode != EMode::None) return;
+
+	FString Path;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SkateReplayInput="), Path))
+	{
+		FilePath = ResolveRecordingPath(Path);
+		if (!LoadRecording())
+		{
+			UE_LOG(LogSkateBGS, Error, TEXT("Could not load input recording %s"), *FilePath);
+			return;
+		}
+
+		Mode = EMode::Replay;
+		FFileHelper::LoadFileToArray(ReferenceHashes, *(FilePath + TEXT(".hash")), FILEREAD_Silent);
+
+		//Live input would fight the recording
+		ASkateCharacter* Skater = GetSkater();
+		if (Skater)
+		{
+			Skater->DisableInput(Cast<APlayerController>(Skater->GetController()));
+			Skater->PrimaryActorTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("SkateRecordInput="), Path))
+	{
+		FilePath = ResolveRecordingPath(Path);
+		Mode = EMode::Record;
+	}
+
+	if (Mode != EMode::None)
+	{
+		//Events are keyed by frame, so recording needs the same step as the replay
+		ForceFixedTimeStep();
+		StartFrameCounter = GFrameCounter;
+		SetComponentTickEnabled(Mode == EMode::Replay);
+		UE_LOG(LogSkateBGS, Display, TEXT("%s input %s"), Mode == EMode::Replay ? TEXT("Replaying") : TEXT("Recording"), *FilePath);
+	}
+}
+
+void USkateInputRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Mode == EMode::Record)
+	{
+		RecordEvent(EEvent::End);
+		if (!SaveRecording())
+		{
+			UE_LOG(LogSkateBGS, Error, TEXT("Could not save input recording %s"), *FilePath);
+		}
+	}
+	else if (Mode == EMode::Replay && ReferenceHashes.Num() == 0)
+	{
+		SaveHashes();
+	}
+	Mode = EMode::None;
+	RestoreTimeStep();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USkateInputRecorder::ForceFixedTimeStep()
+{
+	if (!bForcedFixedTimeStep)
+	{
+		bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+		bForcedFixedTimeStep = true;
+	}
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedDeltaTime);
+}
+
+void USkateInputRecorder::RestoreTimeStep()
+{
+	if (!bForcedFixedTimeStep) return;
+
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+	bForcedFixedTimeStep = false;
+}
+
+ASkateCharacter* USkateInputRecorder::GetSkater() const
+{
+	return Cast<ASkateCharacter>(GetOwner());
+}
+
+uint32 USkateInputRecorder::GetFrame() const
+{
+	return (uint32)(GFrameCounter - StartFrameCounter);
+}
+
+uint32 USkateInputRecorder::HashState() const
+{
+	const ASkateCharacter* Skater = GetSkater();
+	if (!Skater) return 0;
+
+	const FVector3f Location(Skater->GetActorLocation());
+	const FVector3f Velocity(Skater->GetVelocity());
+	uint32 Hash = FCrc::MemCrc32(&Location, sizeof(Location));
+	Hash = FCrc::MemCrc32(&Velocity, sizeof(Velocity), Hash);
+	Hash = FCrc::MemCrc32(&Skater->Stamina, sizeof(Skater->Stamina), Hash);
+	return FCrc::MemCrc32(&Skater->RingCounter, sizeof(Skater->RingCounter), Hash);
+}
+
+void USkateInputRecorder::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Mode != EMode::Replay) return;
+
+	const uint32 Frame = GetFrame();
+	CheckStateHash(Frame);
+
+	while (Events.IsValidIndex(NextEvent) && Events[NextEvent].Frame <= Frame)
+	{
+		DispatchEvent(Events[NextEvent++]);
+	}
+
+	if (bMoveHeld)
+	{
+		if (ASkateCharacter* Skater = GetSkater())
+		{
+			Skater->MoveTrigger(FInputActionValue(FVector2D(LastMove)));
+		}
+	}
+}
+
+void USkateInputRecorder::CheckStateHash(uint32 Frame)
+{
+	const uint32 Hash = HashState();
+	if (ReferenceHashes.Num() == 0)
+	{
+		StateHashes.Add(Hash);
+		return;
+	}
+
+	const int32 Index = Frame * sizeof(uint32);
+	if (!bReportedDivergence && ReferenceHashes.IsValidIndex(Index + 3))
+	{
+		uint32 Reference;
+		FMemory::Memcpy(&Reference, &ReferenceHashes[Index], sizeof(Reference));
+		if (Reference != Hash)
+		{
+			bReportedDivergence = true;
+			UE_LOG(LogSkateBGS, Warning, TEXT("Input replay diverged at frame %u (expected %08x, got %08x)"), Frame, Reference, Hash);
+		}
+	}
+}
+
+void USkateInputRecorder::DispatchEvent(const FEvent& Event)
+{
+	ASkateCharacter* Skater = GetSkater();
+	if (!Skater) return;
+
+	switch (Event.Type)
+	{
+	case EEvent::Move:
+		bMoveHeld = true;
+		LastMove = Event.Value;
+		break;
+	case EEvent::MoveReleased:
+		bMoveHeld = false;
+		Skater->ReleaseTrigger();
+		break;
+	case EEvent::Look:
+		Skater->Look(FInputActionValue(FVector2D(Event.Value)));
+		break;
+	case EEvent::Jump:
+		Skater->Jump();
+		break;
+	case EEvent::JumpReleased:
+		Skater->StopJumping();
+		break;
+	case EEvent::Speed:
+		Skater->SpeedTrigger();
+		break;
+	case EEvent::SpeedReleased:
+		Skater->SlowDown();
+		break;
+	case EEvent::End:
+		UE_LOG(LogSkateBGS, Display, TEXT("Input replay finished at frame %u%s"), Event.Frame, bReportedDivergence ? TEXT(" with divergence") : TEXT(""));
+		break;
+	}
+}
+
+void USkateInputRecorder::BindInput(UEnhancedInputComponent* InputComponent, const UInputAction* MoveAction, const UInputAction* LookAction,
+	const UInputAction* JumpAction, const UInputAction* SpeedAction)
+{
+	if (!InputComponent) return;
+
+	InputComponent->BindAction(MoveAction, ETriggerEvent::Triggered, this, &USkateInputRecorder::OnMove);
+	InputComponent->BindAction(MoveAction, ETriggerEvent::Completed, this, &USkateInputRecorder::OnMoveReleased);
+	InputComponent->BindAction(LookAction, ETriggerEvent::Triggered, this, &USkateInputRecorder::OnLook);
+	InputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &USkateInputRecorder::OnJump);
+	InputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &USkateInputRecorder::OnJumpReleased);
+	InputComponent->BindAction(SpeedAction, ETriggerEvent::Started, this, &USkateInputRecorder::OnSpeed);
+	InputComponent->BindAction(SpeedAction, ETriggerEvent::Completed, this, &USkateInputRecorder::OnSpeedReleased);
+}
+
+void USkateInputRecorder::RecordEvent(EEvent Type, const FVector2f& Value)
+{
+	if (Mode != EMode::Record) return;
+
+	FEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Frame = GetFrame();
+	Event.Type = Type;
+	Event.Value = Value;
+}
+
+void USkateInputRecorder::OnMove(const FInputActionValue& Value)
+{
+	const FVector2f Move(Value.Get<FVector2D>());
+	if (!bMoveHeld || Move != LastMove)
+	{
+		bMoveHeld = true;
+		LastMove = Move;
+		RecordEvent(EEvent::Move, Move);
+	}
+}
+
+void USkateInputRecorder::OnMoveReleased()
+{
+	bMoveHeld = false;
+	RecordEvent(EEvent::MoveReleased);
+}
+
+void USkateInputRecorder::OnLook(const FInputActionValue& Value)
+{
+	RecordEvent(EEvent::Look, FVector2f(Value.Get<FVector2D>()));
+}
+
+void USkateInputRecorder::OnJump()
+{
+	RecordEvent(EEvent::Jump);
+}
+
+void USkateInputRecorder::OnJumpReleased()
+{
+	RecordEvent(EEvent::JumpReleased);
+}
+
+void USkateInputRecorder::OnSpeed()
+{
+	RecordEvent(EEvent::Speed);
+}
+
+void USkateInputRecorder::OnSpeedReleased()
+{
+	RecordEvent(EEvent::SpeedReleased);
+}
+
+bool USkateInputRecorder::SaveRecording() const
+{
+	//Header, then per event: packed frame delta, type, and a value for Move/Look only
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = RecordingMagic;
+	uint16 Version = RecordingVersion;
+	float DeltaTime = FixedDeltaTime;
+	Writer << Magic << Version << DeltaTime;
+
+	uint32 PreviousFrame = 0;
+	for (const FEvent& Event : Events)
+	{
+		uint32 FrameDelta = Event.Frame - PreviousFrame;
+		uint8 Type = (uint8)Event.Type;
+		Writer.SerializeIntPacked(FrameDelta);
+		Writer << Type;
+		if (Event.Type == EEvent::Move || Event.Type == EEvent::Look)
+		{
+			FVector2f Value = Event.Value;
+			Writer << Value;
+		}
+		PreviousFrame = Event.Frame;
+	}
+
+	return FFileHelper::SaveArrayToFile(Data, *FilePath);
+}
+
+bool USkateInputRecorder::LoadRecording()
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath)) return false;
+
+	FMemoryReader Reader(Data);
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	Reader << Magic << Version << FixedDeltaTime;
+	if (Magic != RecordingMagic || Version != RecordingVersion) return false;
+
+	Events.Reset();
+	uint32 Frame = 0;
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		uint32 FrameDelta = 0;
+		uint8 Type = 0;
+		Reader.SerializeIntPacked(FrameDelta);
+		Reader << Type;
+
+		FEvent& Event = Events.AddDefaulted_GetRef();
+		Frame += FrameDelta;
+		Event.Frame = Frame;
+		Event.Type = (EEvent)Type;
+		if (Event.Type == EEvent::Move || Event.Type == EEvent::Look)
+		{
+			Reader << Event.Value;
+		}
+	}
+	return !Reader.IsError();
+}
+
+void USkateInputRecorder::SaveHashes() const
+{
+	TArray<uint8> Data;
+	Data.Append(reinterpret_cast<const uint8*>(StateHashes.GetData()), StateHashes.Num() * sizeof(uint32));
+	if (FFileHelper::SaveArrayToFile(Data, *(FilePath + TEXT(".hash"))))
+	{
+		UE_LOG(LogSkateBGS, Display, TEXT("Wrote %d replay state hashes"), StateHashes.Num());
+	}
+}
@@ -0,0 +1,338 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateMovementComponent.h"
+#include "Characters/SkateCharacter.h"
+#include "GameFramework/Character.h"
+
+/** Saved move carrying the boost button, the boost state at the start of the move and the stamina at its end */
+class FSavedMove_Skate : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override
+	{
+		Super::Clear();
+		bSavedWantsToBoost = false;
+		bSavedBoostExhausted = false;
+		SavedBoostState = FSkateSimState();
+		SavedEndStamina = 0.f;
+	}
+
+	virtual uint8 GetCompressedFlags() const override
+	{
+		uint8 Flags = Super::GetCompressedFlags();
+		if (bSavedWantsToBoost)
+		{
+			Flags |= FLAG_Custom_0;
+		}
+		return Flags;
+	}
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override
+	{
+		const FSavedMove_Skate* NewSkateMove = static_cast<const FSavedMove_Skate*>(NewMove.Get());
+		if (bSavedWantsToBoost != NewSkateMove->bSavedWantsToBoost
+			|| SavedBoostState.bIsSpeedingUp != NewSkateMove->SavedBoostState.bIsSpeedingUp)
+		{
+			return false;
+		}
+		return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+	}
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override
+	{
+		Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+		if (const USkateMovementComponent* Movement = Cast<USkateMovementComponent>(C->GetCharacterMovement()))
+		{
+			bSavedWantsToBoost = Movement->bWantsToBoost;
+			bSavedBoostExhausted = Movement->bBoostExhausted;
+			SavedBoostState = Movement->BoostState;
+		}
+	}
+
+	virtual void PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode) override
+	{
+		Super::PostUpdate(C, PostUpdateMode);
+
+		if (const USkateMovementComponent* Movement = Cast<USkateMovementComponent>(C->GetCharacterMovement()))
+		{
+			SavedEndStamina = Movement->BoostState.Stamina;
+		}
+	}
+
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override
+	{
+		Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+		//The combined move runs again from the pending move's start, the boost has to go back there too
+		const FSavedMove_Skate* OldSkateMove = static_cast<const FSavedMove_Skate*>(OldMove);
+		if (USkateMovementComponent* Movement = Cast<USkateMovementComponent>(InCharacter->GetCharacterMovement()))
+		{
+			Movement->bBoostExhausted = OldSkateMove->bSavedBoostExhausted;
+			Movement->BoostState = OldSkateMove->SavedBoostState;
+			Movement->MaxWalkSpeed = OldSkateMove->SavedBoostState.MaxWalkSpeed;
+		}
+	}
+
+	//Replayed moves don't restore the boost state, they step it from the server's correction
+
+	bool bSavedWantsToBoost = false;
+	bool bSavedBoostExhausted = false;
+	FSkateSimState SavedBoostState;
+	float SavedEndStamina = 0.f;
+};
+
+class FNetworkPredictionData_Client_Skate : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Skate(const UCharacterMovementComponent& ClientMovement)
+		: Super(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
+	{
+		return FSavedMovePtr(new FSavedMove_Skate());
+	}
+};
+
+void FSkateNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	Stamina = static_cast<const FSavedMove_Skate&>(ClientMove).SavedEndStamina;
+}
+
+bool FSkateNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	Ar << Stamina;
+	return !Ar.IsError();
+}
+
+FSkateNetworkMoveDataContainer::FSkateNetworkMoveDataContainer()
+{
+	NewMoveData = &SkateMoveData[0];
+	PendingMoveData = &SkateMoveData[1];
+	OldMoveData = &SkateMoveData[2];
+}
+
+void FSkateMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	const USkateMovementComponent& Movement = static_cast<const USkateMovementComponent&>(CharacterMovement);
+	BoostState = Movement.BoostState;
+	bBoostExhausted = Movement.bBoostExhausted;
+}
+
+bool FSkateMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap))
+	{
+		return false;
+	}
+
+	if (IsCorrection())
+	{
+		Ar << BoostState.Stamina;
+		Ar << BoostState.MaxWalkSpeed;
+
+		uint8 Flags = (BoostState.bIsSpeedingUp ? 1 : 0) | (bBoostExhausted ? 2 : 0);
+		Ar.SerializeBits(&Flags, 2);
+		BoostState.bIsSpeedingUp = (Flags & 1) != 0;
+		bBoostExhausted = (Flags & 2) != 0;
+	}
+	return !Ar.IsError();
+}
+
+USkateMovementComponent::USkateMovementComponent()
+{
+	bOrientRotationToMovement = false;
+
+	SetNetworkMoveDataContainer(SkateMoveDataContainer);
+	SetMoveResponseDataContainer(SkateMoveResponseDataContainer);
+}
+
+void USkateMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	BoostState = SkateSim::MakeInitialState(GetSimParams());
+	MaxWalkSpeed = BoostState.MaxWalkSpeed;
+	if (bUseSkateMovementMode && MovementMode == MOVE_Walking)
+	{
+		SetMovementMode(MOVE_Custom, CMOVE_Skate);
+	}
+}
+
+FSkateSimParams USkateMovementComponent::GetSimParams() const
+{
+	if (const ASkateCharacter* Skater = Cast<ASkateCharacter>(CharacterOwner))
+	{
+		return Skater->GetSimParams();
+	}
+	return FSkateSimParams();
+}
+
+void USkateMovementComponent::SetWantsToBoost(bool bWants)
+{
+	bWantsToBoost = bWants;
+}
+
+bool USkateMovementComponent::IsMovingOnGround() const
+{
+	return Super::IsMovingOnGround() || (MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Skate && UpdatedComponent);
+}
+
+float USkateMovementComponent::GetMaxSpeed() const
+{
+	if (MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Skate)
+	{
+		return MaxWalkSpeed;
+	}
+	return Super::GetMaxSpeed();
+}
+
+float USkateMovementComponent::GetMaxBrakingDeceleration() const
+{
+	if (MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Skate)
+	{
+		return BrakingDecelerationWalking;
+	}
+	return Super::GetMaxBrakingDeceleration();
+}
+
+FNetworkPredictionData_Client* USkateMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		USkateMovementComponent* MutableThis = const_cast<USkateMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Skate(*this);
+	}
+	return ClientPredictionData;
+}
+
+void USkateMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToBoost = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+void USkateMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	//Runs inside every move on the owning client and the server, and again when the client replays moves
+	const FSkateSimParams Params = GetSimParams();
+	if (!bWantsToBoost)
+	{
+		bBoostExhausted = false;
+		SkateSim::StopBoost(BoostState);
+	}
+	else if (!BoostState.bIsSpeedingUp && !bBoostExhausted && !IsFalling())
+	{
+		SkateSim::StartBoost(BoostState, Params);
+	}
+
+	const bool bWasSpeedingUp = BoostState.bIsSpeedingUp;
+	SkateSim::StepBoost(BoostState, Params, Velocity.Size(), DeltaSeconds);
+	if (bWasSpeedingUp && !BoostState.bIsSpeedingUp)
+	{
+		bBoostExhausted = true;
+	}
+	MaxWalkSpeed = BoostState.MaxWalkSpeed;
+}
+
+bool USkateMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc,
+	UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	if (Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientLoc, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode))
+	{
+		return true;
+	}
+
+	const FSkateNetworkMoveData* MoveData = static_cast<const FSkateNetworkMoveData*>(GetCurrentNetworkMoveData());
+	return MoveData && FMath::Abs(MoveData->Stamina - BoostState.Stamina) > StaminaErrorTolerance;
+}
+
+void USkateMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	//Take the server's boost before the pending moves are replayed on top of it
+	if (MoveResponse.IsCorrection())
+	{
+		const FSkateMoveResponseDataContainer& SkateResponse = static_cast<const FSkateMoveResponseDataContainer&>(MoveResponse);
+		BoostState = SkateResponse.BoostState;
+		bBoostExhausted = SkateResponse.bBoostExhausted;
+		MaxWalkSpeed = BoostState.MaxWalkSpeed;
+	}
+
+	Super::ClientHandleMoveResponse(MoveResponse);
+}
+
+void USkateMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	//Landing and spawning put the character back in walking
+	if (bUseSkateMovementMode && MovementMode == MOVE_Walking)
+	{
+		SetMovementMode(MOVE_Custom, CMOVE_Skate);
+	}
+	else if (HasValidData() && MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Skate)
+	{
+		//Leaving walking cleared the floor, find it again so the first skate move does not stall
+		FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, false);
+	}
+}
+
+void USkateMovementComponent::PhysCustom(float DeltaTime, int32 Iterations)
+{
+	Super::PhysCustom(DeltaTime, Iterations);
+
+	if (CustomMovementMode == CMOVE_Skate)
+	{
+		PhysSkate(DeltaTime, Iterations);
+	}
+}
+
+void USkateMovementComponent::HandleImpact(const FHitResult& Hit, float TimeSlice, const FVector& MoveDelta)
+{
+	Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+
+	//Floors and ramps aren't crashes, and replayed moves already reported their impacts
+	if (!CharacterOwner || CharacterOwner->bClientUpdating || IsWalkable(Hit)) return;
+
+	if (ASkateCharacter* Skater = Cast<ASkateCharacter>(CharacterOwner))
+	{
+		//Velocity still holds what this move was going at, it is recomputed after the slide
+		Skater->OnSkateImpact(Hit, Velocity);
+	}
+}
+
+void USkateMovementComponent::PhysSkate(float DeltaTime, int32 Iterations)
+{
+	//The owning client turns the actor itself and pushes along its forward vector, so on the server the
+	//board follows the direction of the received acceleration
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_Authority && !CharacterOwner->IsLocallyControlled() && Acceleration.SizeSquared2D() > KINDA_SMALL_NUMBER)
+	{
+		FVector Heading = Acceleration.GetSafeNormal2D();
+		if ((Heading | UpdatedComponent->GetForwardVector()) < 0.f)
+		{
+			Heading = -Heading;
+		}
+		const FRotator Rotation(UpdatedComponent->GetComponentRotation().Pitch, Heading.Rotation().Yaw, UpdatedComponent->GetComponentRotation().Roll);
+		MoveUpdatedComponent(FVector::ZeroVector, Rotation, false);
+	}
+
+	//The skate rides on the walking floor logic, IsMovingOnGround and the speed and braking overrides
+	//make it treat this mode as grounded. Walking off a ledge still switches to falling from in here.
+	PhysWalking(DeltaTime, Iterations);
+}
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateSimulation.h"
+
+namespace SkateSim
+{
+	FSkateSimState MakeInitialState(const FSkateSimParams& Params)
+	{
+		FSkateSimState State;
+		State.MaxWalkSpeed = Params.RegularSpeed;
+		State.Stamina = Params.MaxStamina;
+		return State;
+	}
+
+	float GetDecelerationScale(const FSkateSimParams& Params, float Speed, float ForwardAxis)
+	{
+		if (Speed > 400.f && ForwardAxis == 0)
+		{
+			const float DecMultiplier = Speed >= Params.RegularSpeed + 100.f ? Speed / 30.f : 1.f;
+			return 1.f / (Params.DecelerationRate * DecMultiplier);
+		}
+		return 1.f;
+	}
+
+	float GetDecayAlpha(float StepAlpha, float DeltaTime, float StepTime)
+	{
+		return 1.f - FMath::Pow(1.f - FMath::Clamp(StepAlpha, 0.f, 1.f), DeltaTime / StepTime);
+	}
+
+	bool CanStartBoost(const FSkateSimInput& Input)
+	{
+		return !Input.bIsFalling && Input.MoveAxis.Y > 0;
+	}
+
+	void StartBoost(FSkateSimState& State, const FSkateSimParams& Params)
+	{
+		State.bIsSpeedingUp = true;
+		State.MaxWalkSpeed = Params.MaxSpeed;
+	}
+
+	void StopBoost(FSkateSimState& State)
+	{
+		State.bIsSpeedingUp = false;
+	}
+
+	void ApplyBoostPush(FSkateSimState& State, const FSkateSimParams& Params, float Speed)
+	{
+		if (Speed < Params.RegularSpeed && State.ForwardScale > .9f)
+		{
+			State.ForwardScale -= 0.2f;
+		}
+	}
+
+	void StepBoost(FSkateSimState& State, const FSkateSimParams& Params, float Speed, float DeltaTime)
+	{
+		//Stamina
+		const float StaminaRate = State.bIsSpeedingUp ? -Params.StaminaDrainPerSecond : Params.StaminaRegenPerSecond;
+		State.Stamina = FMath::Clamp(State.Stamina + StaminaRate * DeltaTime, 0.f, Params.MaxStamina);
+		if (State.bIsSpeedingUp && State.Stamina <= 0.f)
+		{
+			StopBoost(State);
+		}
+
+		//Top speed settles back to the regular speed once the boost ends, the rate is per 60 Hz step
+		if (!State.bIsSpeedingUp)
+		{
+			if (Speed > Params.RegularSpeed)
+			{
+				const float Alpha = GetDecayAlpha(Params.Friction / Params.DecelerationRate, DeltaTime, Params.FixedTimeStep);
+				State.MaxWalkSpeed = FMath::Lerp(State.MaxWalkSpeed, Params.RegularSpeed, Alpha);
+			}
+			if (Speed < Params.RegularSpeed - 100 && State.MaxWalkSpeed > Params.RegularSpeed)
+			{
+				State.MaxWalkSpeed = Params.RegularSpeed;
+			}
+		}
+	}
+
+	float GetTurn(const FSkateSimState& State, const FSkateSimParams& Params, const FSkateSimInput& Input)
+	{
+		//Turning gets sharper with speed
+		const float TurnPercent = Params.TurnRate / State.MaxWalkSpeed;
+		return Input.MoveAxis.X * FMath::Max(Input.Speed * TurnPercent, 0.25f);
+	}
+
+	float Step(FSkateSimState& State, const FSkateSimParams& Params, const FSkateSimInput& Input)
+	{
+		//Forward push, eased towards the input and pushed by the slope. The alpha is per fixed step, so it already decays at the same rate for any tick rate
+		const float Forward = FMath::Clamp(Input.MoveAxis.Y, 0.f, 1.f);
+		const float ZForward = Input.bIsFalling ? 0.f : FMath::Clamp(Input.SlopeZ * 3, -0.8f, 0.8f);
+		const float DecelerationScale = GetDecelerationScale(Params, Input.Speed, Input.MoveAxis.Y);
+		State.ForwardScale = FMath::Lerp(State.ForwardScale, Forward - ZForward, Params.Friction * DecelerationScale);
+
+		return GetTurn(State, Params, Input);
+	}
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/SkateTraceQueries.h"
+#include "Engine/World.h"
+#include "SkateBGSStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces"), STAT_SkateTraces, STATGROUP_SkateBGS);
+
+FSkateTraceQueries::FSkateTraceQueries()
+	: QueryParams(SCENE_QUERY_STAT(SkateTrace), false)
+	, ResponseParams(FCollisionResponseParams::DefaultResponseParam)
+{
+}
+
+void FSkateTraceQueries::Init(const AActor* InOwner, ETraceTypeQuery TraceType)
+{
+	QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(SkateTrace), false, InOwner);
+	Channel = UEngineTypes::ConvertToCollisionChannel(TraceType);
+}
+
+void FSkateTraceQueries::BeginFrame()
+{
+	FrameQueries = 0;
+}
+
+void FSkateTraceQueries::CountQuery()
+{
+	FrameQueries += 1;
+	INC_DWORD_STAT(STAT_SkateTraces);
+}
+
+bool FSkateTraceQueries::LineTrace(const UWorld* World, const FVector& Start, const FVector& End, FHitResult& OutHit)
+{
+	if (!World) return false;
+
+	CountQuery();
+	return World->LineTraceSingleByChannel(OutHit, Start, End, Channel, QueryParams, ResponseParams);
+}
+
+bool FSkateTraceQueries::BoxSweep(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfExtent, FHitResult& OutHit)
+{
+	if (!World) return false;
+
+	CountQuery();
+	return World->SweepSingleByChannel(OutHit, Start, End, Rotation, Channel, FCollisionShape::MakeBox(HalfExtent), QueryParams, ResponseParams);
+}
+
+FTraceHandle FSkateTraceQueries::AsyncLineTrace(UWorld* World, const FVector& Start, const FVector& End, const FTraceDelegate* Delegate, uint32 UserData)
+{
+	if (!World) return FTraceHandle();
+
+	CountQuery();
+	return World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, Channel, QueryParams, ResponseParams, Delegate, UserData);
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Effects/SkateEffectsSubsystem.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "Components/AudioComponent.h"
+#include "AudioDevice.h"
+#include "Sound/SoundBase.h"
+
+namespace
+{
+	//Prefers a component that finished playing, otherwise restarts the oldest one
+	template <typename ComponentType, typename IsBusyType>
+	ComponentType* TakeComponent(TArray<ComponentType*>& Components, int32& Next, IsBusyType IsBusy)
+	{
+		const int32 Num = Components.Num();
+		for (int32 Offset = 0; Offset < Num; ++Offset)
+		{
+			const int32 Index = (Next + Offset) % Num;
+			if (Components[Index] && !IsBusy(Components[Index]))
+			{
+				Next = (Index + 1) % Num;
+				return Components[Index];
+			}
+		}
+
+		ComponentType* Oldest = Num > 0 ? Components[Next] : nullptr;
+		Next = Num > 0 ? (Next + 1) % Num : 0;
+		return Oldest;
+	}
+}
+
+bool USkateEffectsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+void USkateEffectsSubsystem::Deinitialize()
+{
+	for (TPair<UNiagaraSystem*, FSkateNiagaraPool>& Pool : EffectPools)
+	{
+		for (UNiagaraComponent* Component : Pool.Value.Components)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	for (TPair<USoundBase*, FSkateSoundPool>& Pool : SoundPools)
+	{
+		for (UAudioComponent* Component : Pool.Value.Components)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	EffectPools.Reset();
+	SoundPools.Reset();
+
+	Super::Deinitialize();
+}
+
+void USkateEffectsSubsystem::Prewarm(UNiagaraSystem* System, int32 Count)
+{
+	if (!System) return;
+
+	FSkateNiagaraPool& Pool = EffectPools.FindOrAdd(System);
+	while (Pool.Components.Num() < Count)
+	{
+		UNiagaraComponent* Component = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), System, FVector::ZeroVector, FRotator::ZeroRotator,
+			FVector(1.f), false, false, ENCPoolMethod::None, false);
+		if (!Component) break;
+		Pool.Components.Add(Component);
+	}
+}
+
+void USkateEffectsSubsystem::Prewarm(USoundBase* Sound, int32 Count)
+{
+	if (!Sound) return;
+
+	FAudioDevice::FCreateComponentParams Params(GetWorld());
+	Params.bAutoDestroy = false;
+	Params.bPlay = false;
+
+	FSkateSoundPool& Pool = SoundPools.FindOrAdd(Sound);
+	while (Pool.Components.Num() < Count)
+	{
+		UAudioComponent* Component = FAudioDevice::CreateComponent(Sound, Params);
+		if (!Component) break;
+		Pool.Components.Add(Component);
+	}
+}
+
+void USkateEffectsSubsystem::PlayEffect(UNiagaraSystem* System, const FVector& Location)
+{
+	if (!System) return;
+
+	//Assets nobody prewarmed still get a pool, they just pay for it on first use
+	FSkateNiagaraPool* Pool = EffectPools.Find(System);
+	if (!Pool)
+	{
+		Prewarm(System);
+		Pool = EffectPools.Find(System);
+	}
+
+	UNiagaraComponent* Component = TakeComponent(Pool->Components, Pool->Next, [](const UNiagaraComponent* Effect) { return Effect->IsActive(); });
+	if (Component)
+	{
+		Component->SetWorldLocation(Location);
+		Component->Activate(true);
+	}
+}
+
+void USkateEffectsSubsystem::PlaySound(USoundBase* Sound, const FVector& Location)
+{
+	if (!Sound) return;
+
+	FSkateSoundPool* Pool = SoundPools.Find(Sound);
+	if (!Pool)
+	{
+		Prewarm(Sound);
+		Pool = SoundPools.Find(Sound);
+	}
+
+	UAudioComponent* Component = TakeComponent(Pool->Components, Pool->Next, [](const UAudioComponent* Audio) { return Audio->IsPlaying(); });
+	if (Component)
+	{
+		Component->SetWorldLocation(Location);
+		Component->Play();
+	}
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SkateLoadingSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Misc/App.h"
+#include "SkateBGSLog.h"
+
+void USkateLoadingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &USkateLoadingSubsystem::OnPreLoadMap);
+
+	//The preload is HUD, VFX and sounds, dedicated servers load what the level references and nothing more
+	if (PreloadAssets.Num() > 0 && UAssetManager::IsInitialized() && !IsRunningDedicatedServer())
+	{
+		PreloadStartTime = FPlatformTime::Seconds();
+		PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(PreloadAssets,
+			FStreamableDelegate::CreateUObject(this, &USkateLoadingSubsystem::OnPreloadComplete), FStreamableManager::AsyncLoadHighPriority);
+	}
+}
+
+void USkateLoadingSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+
+	if (PreloadHandle.IsValid())
+	{
+		PreloadHandle->CancelHandle();
+		PreloadHandle.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+bool USkateLoadingSubsystem::IsPreloadComplete() const
+{
+	return !PreloadHandle.IsValid() || PreloadHandle->HasLoadCompleted();
+}
+
+float USkateLoadingSubsystem::GetPreloadProgress() const
+{
+	return PreloadHandle.IsValid() ? PreloadHandle->GetProgress() : 1.f;
+}
+
+void USkateLoadingSubsystem::OnPreloadComplete()
+{
+	UE_LOG(LogSkateBGS, Log, TEXT("Preloaded %d gameplay assets in %.2fs"), PreloadAssets.Num(), FPlatformTime::Seconds() - PreloadStartTime);
+}
+
+void USkateLoadingSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	MapLoadStartTime = FPlatformTime::Seconds();
+	LoadingMapName = MapName;
+	bWaitingForControllable = true;
+}
+
+void USkateLoadingSubsystem::NotifyPlayerControllable()
+{
+	if (!bWaitingForControllable) return;
+	bWaitingForControllable = false;
+
+	const double Now = FPlatformTime::Seconds();
+	const double SinceMapLoad = MapLoadStartTime > 0.0 ? Now - MapLoadStartTime : Now - GStartTime;
+	UE_LOG(LogSkateBGS, Display, TEXT("Time to first controllable frame: %.2fs since launch, %.2fs since loading %s (preload %s)"),
+		Now - GStartTime, SinceMapLoad, LoadingMapName.IsEmpty() ? TEXT("the startup map") : *LoadingMapName,
+		IsPreloadComplete() ? TEXT("complete") : TEXT("still loading"));
+}
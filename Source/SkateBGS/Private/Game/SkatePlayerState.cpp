@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/SkatePlayerState.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+void ASkatePlayerState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ASkatePlayerState, RingIndex, Params);
+}
+
+void ASkatePlayerState::SetRingIndex(int32 NewRingIndex)
+{
+	if (!HasAuthority() || NewRingIndex == RingIndex) return;
+
+	const int32 OldRingIndex = RingIndex;
+	RingIndex = NewRingIndex;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASkatePlayerState, RingIndex, this);
+	//Player states update rarely, send ring progress right away
+	ForceNetUpdate();
+	OnRingProgressChanged.Broadcast(OldRingIndex, RingIndex);
+}
+
+void ASkatePlayerState::OnRep_RingIndex(int32 OldRingIndex)
+{
+	OnRingProgressChanged.Broadcast(OldRingIndex, RingIndex);
+}
@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Ghost/GhostRecording.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+namespace
+{
+	constexpr uint32 GhostMagic = 0x54534847; // "GHST"
+	constexpr uint16 GhostVersion = 1;
+	constexpr int32 HeaderSize = sizeof(uint32) + sizeof(uint16) + sizeof(float) + sizeof(uint32);
+	constexpr int32 MaxFrameSize = 64;
+	constexpr int32 WriteFlushSize = 64 * 1024;
+	constexpr int32 ReadWindowSize = 16 * 1024;
+	constexpr float LocationScale = 10.f;
+
+	enum EGhostFlags : uint8
+	{
+		Falling = 1 << 0,
+		SpeedingUp = 1 << 1,
+		Flipping = 1 << 2
+	};
+
+	void WriteVarInt(TArray<uint8>& Out, int32 Value)
+	{
+		uint32 ZigZag = (uint32)((Value << 1) ^ (Value >> 31));
+		do
+		{
+			uint8 Byte = ZigZag & 0x7F;
+			ZigZag >>= 7;
+			Out.Add(ZigZag ? (Byte | 0x80) : Byte);
+		} while (ZigZag);
+	}
+
+	int32 ReadVarInt(const uint8* Data, int32& Pos)
+	{
+		uint32 ZigZag = 0;
+		int32 Shift = 0;
+		uint8 Byte;
+		do
+		{
+			Byte = Data[Pos++];
+			ZigZag |= (uint32)(Byte & 0x7F) << Shift;
+			Shift += 7;
+		} while ((Byte & 0x80) && Shift < 35);
+		return (int32)(ZigZag >> 1) ^ -(int32)(ZigZag & 1);
+	}
+
+	void WriteHeader(uint8* Out, float RunTime, uint32 NumFrames)
+	{
+		const uint32 Magic = GhostMagic;
+		const uint16 Version = GhostVersion;
+		FMemory::Memcpy(Out, &Magic, sizeof(Magic));
+		FMemory::Memcpy(Out + 4, &Version, sizeof(Version));
+		FMemory::Memcpy(Out + 6, &RunTime, sizeof(RunTime));
+		FMemory::Memcpy(Out + 10, &NumFrames, sizeof(NumFrames));
+	}
+
+	bool ReadHeader(IFileHandle* File, float& OutRunTime, uint32& OutNumFrames)
+	{
+		uint8 Header[HeaderSize];
+		if (!File || !File->Read(Header, HeaderSize)) return false;
+
+		uint32 Magic;
+		uint16 Version;
+		FMemory::Memcpy(&Magic, Header, sizeof(Magic));
+		FMemory::Memcpy(&Version, Header + 4, sizeof(Version));
+		FMemory::Memcpy(&OutRunTime, Header + 6, sizeof(OutRunTime));
+		FMemory::Memcpy(&OutNumFrames, Header + 10, sizeof(OutNumFrames));
+		return Magic == GhostMagic && Version == GhostVersion;
+	}
+}
+
+FGhostFrame FGhostFrame::Lerp(const FGhostFrame& A, const FGhostFrame& B, float Alpha)
+{
+	FGhostFrame Result = Alpha < 0.5f ? A : B;
+	Result.Time = FMath::Lerp(A.Time, B.Time, Alpha);
+	Result.Location = FMath::Lerp(A.Location, B.Location, Alpha);
+	Result.Rotation = FQuat::Slerp(A.Rotation.Quaternion(), B.Rotation.Quaternion(), Alpha).Rotator();
+	Result.SkateRotation = FQuat::Slerp(A.SkateRotation.Quaternion(), B.SkateRotation.Quaternion(), Alpha).Rotator();
+	Result.Speed = FMath::Lerp(A.Speed, B.Speed, Alpha);
+	return Result;
+}
+
+FGhostQuantizedFrame FGhostQuantizedFrame::Quantize(const FGhostFrame& Frame)
+{
+	FGhostQuantizedFrame Quantized;
+	Quantized.TimeMs = FMath::RoundToInt(Frame.Time * 1000.f);
+	Quantized.Location = FIntVector(
+		FMath::RoundToInt(Frame.Location.X * LocationScale),
+		FMath::RoundToInt(Frame.Location.Y * LocationScale),
+		FMath::RoundToInt(Frame.Location.Z * LocationScale));
+	Quantized.Rotation[0] = FRotator::CompressAxisToShort(Frame.Rotation.Pitch);
+	Quantized.Rotation[1] = FRotator::CompressAxisToShort(Frame.Rotation.Yaw);
+	Quantized.Rotation[2] = FRotator::CompressAxisToShort(Frame.Rotation.Roll);
+	Quantized.SkateRotation[0] = FRotator::CompressAxisToShort(Frame.SkateRotation.Pitch);
+	Quantized.SkateRotation[1] = FRotator::CompressAxisToShort(Frame.SkateRotation.Yaw);
+	Quantized.SkateRotation[2] = FRotator::CompressAxisToShort(Frame.SkateRotation.Roll);
+	Quantized.Speed = FMath::RoundToInt(Frame.Speed);
+	Quantized.Flags = (Frame.bIsFalling ? Falling : 0) | (Frame.bIsSpeedingUp ? SpeedingUp : 0) | (Frame.bIsFlipping ? Flipping : 0);
+	return Quantized;
+}
+
+FGhostFrame FGhostQuantizedFrame::Dequantize() const
+{
+	FGhostFrame Frame;
+	Frame.Time = TimeMs / 1000.f;
+	Frame.Location = FVector(Location) / LocationScale;
+	Frame.Rotation = FRotator(FRotator::DecompressAxisFromShort(Rotation[0]), FRotator::DecompressAxisFromShort(Rotation[1]), FRotator::DecompressAxisFromShort(Rotation[2]));
+	Frame.SkateRotation = FRotator(FRotator::DecompressAxisFromShort(SkateRotation[0]), FRotator::DecompressAxisFromShort(SkateRotation[1]), FRotator::DecompressAxisFromShort(SkateRotation[2]));
+	Frame.Speed = (float)Speed;
+	Frame.bIsFalling = (Flags & Falling) != 0;
+	Frame.bIsSpeedingUp = (Flags & SpeedingUp) != 0;
+	Frame.bIsFlipping = (Flags & Flipping) != 0;
+	return Frame;
+}
+
+FGhostWriter::~FGhostWriter()
+{
+	Discard();
+}
+
+bool FGhostWriter::Begin(const FString& InFinalPath)
+{
+	Discard();
+
+	FinalPath = InFinalPath;
+	TempPath = FinalPath + TEXT(".tmp");
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(FinalPath), true);
+	File = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*TempPath);
+	if (!File) return false;
+
+	//Header is patched with the run time and frame count in Finish
+	Buffer.Reset();
+	Buffer.AddZeroed(HeaderSize);
+	Previous = FGhostQuantizedFrame();
+	NumFrames = 0;
+	return true;
+}
+
+void FGhostWriter::AddFrame(const FGhostFrame& Frame)
+{
+	if (!File) return;
+
+	const FGhostQuantizedFrame Current = FGhostQuantizedFrame::Quantize(Frame);
+	WriteVarInt(Buffer, Current.TimeMs - Previous.TimeMs);
+	WriteVarInt(Buffer, Current.Location.X - Previous.Location.X);
+	WriteVarInt(Buffer, Current.Location.Y - Previous.Location.Y);
+	WriteVarInt(Buffer, Current.Location.Z - Previous.Location.Z);
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		WriteVarInt(Buffer, (int16)(Current.Rotation[Axis] - Previous.Rotation[Axis]));
+		WriteVarInt(Buffer, (int16)(Current.SkateRotation[Axis] - Previous.SkateRotation[Axis]));
+	}
+	WriteVarInt(Buffer, Current.Speed - Previous.Speed);
+	Buffer.Add(Current.Flags);
+
+	Previous = Current;
+	NumFrames += 1;
+
+	if (Buffer.Num() >= WriteFlushSize)
+	{
+		Flush();
+	}
+}
+
+void FGhostWriter::Flush()
+{
+	if (File && Buffer.Num() > 0)
+	{
+		File->Write(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+}
+
+bool FGhostWriter::Finish(float RunTime)
+{
+	if (!File) return false;
+
+	Flush();
+	uint8 Header[HeaderSize];
+	WriteHeader(Header, RunTime, NumFrames);
+	File->Seek(0);
+	File->Write(Header, HeaderSize);
+	delete File;
+	File = nullptr;
+
+	if (RunTime >= FGhostReader::ReadRunTime(FinalPath))
+	{
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+	return IFileManager::Get().Move(*FinalPath, *TempPath, true);
+}
+
+void FGhostWriter::Discard()
+{
+	if (File)
+	{
+		delete File;
+		File = nullptr;
+		IFileManager::Get().Delete(*TempPath);
+	}
+	Buffer.Empty();
+}
+
+FGhostReader::~FGhostReader()
+{
+	Close();
+}
+
+bool FGhostReader::Open(const FString& Path)
+{
+	Close();
+
+	File = FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path);
+	if (!ReadHeader(File, RunTime, NumFrames))
+	{
+		Close();
+		return false;
+	}
+
+	FileRemaining = File->Size() - HeaderSize;
+	Window.SetNumUninitialized(ReadWindowSize);
+	WindowPos = 0;
+	WindowEnd = 0;
+	Previous = FGhostQuantizedFrame();
+	FramesRead = 0;
+	Refill();
+	return true;
+}
+
+void FGhostReader::Close()
+{
+	delete File;
+	File = nullptr;
+	Window.Empty();
+}
+
+void FGhostReader::Refill()
+{
+	//Slide what's left to the front and top the window up from the file
+	const int32 Left = WindowEnd - WindowPos;
+	if (Left > 0 && WindowPos > 0)
+	{
+		FMemory::Memmove(Window.GetData(), Window.GetData() + WindowPos, Left);
+	}
+	WindowPos = 0;
+	WindowEnd = Left;
+
+	const int32 ToRead = (int32)FMath::Min<int64>(Window.Num() - WindowEnd, FileRemaining);
+	if (ToRead > 0 && File->Read(Window.GetData() + WindowEnd, ToRead))
+	{
+		WindowEnd += ToRead;
+		FileRemaining -= ToRead;
+	}
+}
+
+bool FGhostReader::ReadFrame(FGhostFrame& OutFrame)
+{
+	if (!File || FramesRead >= NumFrames) return false;
+
+	if (WindowEnd - WindowPos < MaxFrameSize)
+	{
+		Refill();
+	}
+	if (WindowPos >= WindowEnd) return false;
+
+	const uint8* Data = Window.GetData();
+	FGhostQuantizedFrame Current;
+	Current.TimeMs = Previous.TimeMs + ReadVarInt(Data, WindowPos);
+	Current.Location.X = Previous.Location.X + ReadVarInt(Data, WindowPos);
+	Current.Location.Y = Previous.Location.Y + ReadVarInt(Data, WindowPos);
+	Current.Location.Z = Previous.Location.Z + ReadVarInt(Data, WindowPos);
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Current.Rotation[Axis] = (uint16)(Previous.Rotation[Axis] + ReadVarInt(Data, WindowPos));
+		Current.SkateRotation[Axis] = (uint16)(Previous.SkateRotation[Axis] + ReadVarInt(Data, WindowPos));
+	}
+	Current.Speed = Previous.Speed + ReadVarInt(Data, WindowPos);
+	Current.Flags = Data[WindowPos++];
+
+	Previous = Current;
+	FramesRead += 1;
+	OutFrame = Current.Dequantize();
+	return true;
+}
+
+float FGhostReader::ReadRunTime(const FString& Path)
+{
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+	float Time = 0.f;
+	uint32 Frames = 0;
+	return ReadHeader(File.Get(), Time, Frames) ? Time : FLT_MAX;
+}
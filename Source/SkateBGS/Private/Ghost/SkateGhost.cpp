@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Ghost/SkateGhost.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+
+ASkateGhost::ASkateGhost()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	SetActorEnableCollision(false);
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	Body = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Body"));
+	Body->SetupAttachment(RootComponent);
+	Body->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Body->SetGenerateOverlapEvents(false);
+
+	SkateMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("SkateMesh"));
+	SkateMesh->SetupAttachment(RootComponent);
+	SkateMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SkateMesh->SetGenerateOverlapEvents(false);
+}
+
+bool ASkateGhost::StartPlayback(const FString& Path)
+{
+	bHasMoreFrames = Reader.Open(Path) && Reader.ReadFrame(FromFrame);
+	if (bHasMoreFrames)
+	{
+		ToFrame = FromFrame;
+		bHasMoreFrames = Reader.ReadFrame(ToFrame);
+		PlaybackTime = FromFrame.Time;
+		ApplyFrame(FromFrame);
+	}
+	SetActorTickEnabled(bHasMoreFrames);
+	return bHasMoreFrames;
+}
+
+void ASkateGhost::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	PlaybackTime += DeltaTime;
+	while (bHasMoreFrames && ToFrame.Time <= PlaybackTime)
+	{
+		FromFrame = ToFrame;
+		bHasMoreFrames = Reader.ReadFrame(ToFrame);
+	}
+
+	if (!bHasMoreFrames)
+	{
+		//Hold the last pose where the run ended
+		ApplyFrame(FromFrame);
+		Reader.Close();
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	const float Span = ToFrame.Time - FromFrame.Time;
+	const float Alpha = Span > 0.f ? (PlaybackTime - FromFrame.Time) / Span : 1.f;
+	ApplyFrame(FGhostFrame::Lerp(FromFrame, ToFrame, Alpha));
+}
+
+void ASkateGhost::ApplyFrame(const FGhostFrame& Frame)
+{
+	SetActorLocationAndRotation(Frame.Location, Frame.Rotation);
+	SkateMesh->SetRelativeRotation(Frame.SkateRotation);
+	Speed = Frame.Speed;
+	bIsFalling = Frame.bIsFalling;
+	bIsSpeedingUp = Frame.bIsSpeedingUp;
+	bIsFlipping = Frame.bIsFlipping;
+}
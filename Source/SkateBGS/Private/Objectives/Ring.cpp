@@ -3,17 +3,26 @@
 
 #include "Objectives/Ring.h"
 #include "Components/SphereComponent.h"
-#include "NiagaraFunctionLibrary.h"
 #include "NiagaraComponent.h"
-#include "Kismet/GameplayStatics.h"
-#include "GameFramework/Character.h"
 #include "Characters/SkateCharacter.h"
+#include "Objectives/RingManager.h"
+#include "Objectives/RingSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "Effects/SkateEffectsSubsystem.h"
+#include "SkateBGSStats.h"
+
+DECLARE_SKATE_CYCLE_STAT(TEXT("Ring Tick"), STAT_SkateRingTick);
 
 // Sets default values
 ARing::ARing()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+ 	// Rings only tick while the bob isn't done by the material
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	//Every machine loads the same rings with the level, their state comes from the player's progress
+	bReplicates = false;
 
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ItemMeshComponent"));
 	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -21,6 +30,8 @@ ARing::ARing()
 
 	Sphere = CreateDefaultSubobject<USphereComponent>(TEXT("Sphere"));
 	Sphere->SetupAttachment(GetRootComponent());
+	Sphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Sphere->SetGenerateOverlapEvents(false);
 
 	VFX = CreateDefaultSubobject<UNiagaraComponent>(TEXT("Niagara Effect"));
 	VFX->SetupAttachment(GetRootComponent());
@@ -35,54 +46,104 @@ void ARing::BeginPlay()
 {
 	Super::BeginPlay();
 
-	Sphere->OnComponentBeginOverlap.AddDynamic(this, &ARing::OnSphereOverlap);
-	Sphere->OnComponentEndOverlap.AddDynamic(this, &ARing::OnSphereEndOverlap);
+	//Blueprints may still carry an overlap profile from before the manager did collection
+	Sphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	//Servers only need the ring's place, the manager never ranks effects there
+	if (IsNetMode(NM_DedicatedServer) && VFX)
+	{
+		VFX->Deactivate();
+		EffectLevel = ERingEffectLevel::Off;
+	}
+
+	BobBaseLocation = GetActorLocation();
+	BobTimeOffset = GetBobTimeOffset();
+	SetActorTickEnabled(ShouldTickBob());
+
+	if (USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>())
+	{
+		Effects->Prewarm(OverlapEffect);
+		Effects->Prewarm(OverlapSound);
+	}
+
+	//Rings streamed in after the course started pick up their state from the manager
+	const URingSubsystem* Rings = GetWorld()->GetSubsystem<URingSubsystem>();
+	if (ARingManager* Manager = Rings ? Rings->GetManager() : nullptr)
+	{
+		Manager->OnRingLoaded(this);
+	}
 	
 }
 
-float ARing::TransformedSin()
+void ARing::OnConstruction(const FTransform& Transform)
 {
-	return Amplitude * FMath::Sin(RunningTime * Period);
+	Super::OnConstruction(Transform);
+
+	if (Mesh)
+	{
+		Mesh->SetDefaultCustomPrimitiveDataFloat(0, GetBobTimeOffset());
+		Mesh->SetDefaultCustomPrimitiveDataFloat(1, Amplitude);
+		Mesh->SetDefaultCustomPrimitiveDataFloat(2, Period);
+	}
 }
 
-float ARing::TransformedCosin()
+#if WITH_EDITOR
+void ARing::PostEditMove(bool bFinished)
 {
-	return Amplitude * FMath::Cos(RunningTime * Period);
+	Super::PostEditMove(bFinished);
+
+	if (!bFinished) return;
+
+	for (TActorIterator<ARingManager> It(GetWorld()); It; ++It)
+	{
+		It->OnRingMoved(this);
+	}
 }
+#endif
 
-void ARing::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ARing::Tick(float DeltaTime)
 {
-	ASkateCharacter* Player = Cast<ASkateCharacter>(OtherActor);
-	if (Player)
-	{
-		if (OverlapEffect)
-		{
-			UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), OverlapEffect, GetActorLocation());
-		}
-		if (OverlapSound)
-		{
-			UGameplayStatics::SpawnSoundAtLocation(GetWorld(), OverlapSound, GetActorLocation());
-		}
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateRingTick);
+	Super::Tick(DeltaTime);
 
-		Player->CollectRing();
+	//Nobody sees rings off screen bob, skip moving them
+	if (!Mesh || !Mesh->WasRecentlyRendered(0.2f)) return;
 
-		Destroy();
-	}
+	const float Time = GetWorld()->GetTimeSeconds() + BobTimeOffset;
+	SetActorLocation(BobBaseLocation + FVector(0.f, 0.f, Amplitude * FMath::Sin(Time * Period)));
 }
 
-void ARing::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+float ARing::GetBobTimeOffset() const
 {
+	//Stable per ring, hand placed rings all leave TimeOffset at 0
+	const float Cycle = Period != 0.f ? 2.f * PI / FMath::Abs(Period) : 0.f;
+	const FRandomStream Stream((int32)GetTypeHash(BobBaseLocation.IsZero() ? GetActorLocation() : BobBaseLocation));
+	return TimeOffset + Stream.FRand() * Cycle;
 }
 
-// Called every frame
-void ARing::Tick(float DeltaTime)
+bool ARing::ShouldTickBob() const
 {
-	Super::Tick(DeltaTime);
+	return !bBobInMaterial && !bIsCollected && !IsNetMode(NM_DedicatedServer);
+}
+
+void ARing::Collect(ASkateCharacter* Player)
+{
+	if (Player && !bIsCollected)
+	{
+		if (USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>())
+		{
+			Effects->PlayEffect(OverlapEffect, GetActorLocation());
+			Effects->PlaySound(OverlapSound, GetActorLocation());
+		}
 
-	RunningTime += DeltaTime;
-	const float Z = TransformedSin();
-	AddActorWorldOffset(FVector(0.f, 0.f, Z));
+		//The manager pools the ring through the RingCollected broadcast
+		Player->CollectRing();
+	}
+}
 
+float ARing::GetCollectRadius() const
+{
+	return Sphere ? Sphere->GetScaledSphereRadius() : 0.f;
 }
 
 void ARing::SetRingInactive()
@@ -91,11 +152,6 @@ void ARing::SetRingInactive()
 	{
 		Mesh->SetMaterial(0, OffMaterial);
 	}
-
-	if (Sphere)
-	{
-		Sphere->SetCollisionResponseToAllChannels(ECR_Ignore);
-	}
 }
 
 void ARing::SetRingActive()
@@ -104,10 +160,57 @@ void ARing::SetRingActive()
 	{
 		Mesh->SetMaterial(0, OnMaterial);
 	}
+}
+
+void ARing::SetRingCollected()
+{
+	bIsCollected = true;
+	SetRingInactive();
+	SetActorHiddenInGame(true);
+
+	if (VFX)
+	{
+		VFX->Deactivate();
+	}
+	EffectLevel = ERingEffectLevel::Off;
+	SetActorTickEnabled(false);
+}
 
-	if (Sphere)
+void ARing::ResetRing()
+{
+	bIsCollected = false;
+	SetActorHiddenInGame(false);
+	SetActorTickEnabled(ShouldTickBob());
+
+	//Effects stay off on servers, like in BeginPlay
+	if (IsNetMode(NM_DedicatedServer)) return;
+
+	if (VFX)
 	{
-		Sphere->SetCollisionResponseToAllChannels(ECR_Overlap);
+		VFX->Activate(true);
+		VFX->SetPaused(false);
+		VFX->SetVariableFloat(SpawnRateScaleParameter, 1.f);
 	}
+	EffectLevel = ERingEffectLevel::Full;
 }
 
+void ARing::SetEffectLevel(ERingEffectLevel Level)
+{
+	if (!VFX || bIsCollected || Level == EffectLevel) return;
+
+	if (Level == ERingEffectLevel::Off)
+	{
+		VFX->Deactivate();
+	}
+	else
+	{
+		//Paused keeps the particles on screen but stops simulating them
+		if (!VFX->IsActive())
+		{
+			VFX->Activate(true);
+		}
+		VFX->SetPaused(Level == ERingEffectLevel::Paused);
+		VFX->SetVariableFloat(SpawnRateScaleParameter, Level == ERingEffectLevel::Reduced ? ReducedSpawnRateScale : 1.f);
+	}
+	EffectLevel = Level;
+}
@@ -2,8 +2,36 @@
 
 
 #include "Objectives/RingManager.h"
+#include "Objectives/RingCourse.h"
+#include "Objectives/RingSubsystem.h"
 #include "Characters/SkateCharacter.h"
+#include "Game/SkatePlayerState.h"
+#include "GameFramework/GameStateBase.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/Engine.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Effects/SkateEffectsSubsystem.h"
+#include "SkateBGSLog.h"
+#include "SkateBGSStats.h"
+#include "HAL/IConsoleManager.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+#include "UObject/ObjectSaveContext.h"
+
+DECLARE_SKATE_CYCLE_STAT(TEXT("Ring Detection"), STAT_SkateRingDetection);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Set Next Ring"), STAT_SkateSetNextRing);
+DECLARE_SKATE_CYCLE_STAT(TEXT("Ring Significance"), STAT_SkateRingSignificance);
+
+namespace
+{
+	TAutoConsoleVariable<int32> CVarMaxActiveRingVFX(
+		TEXT("skate.Rings.MaxActiveVFX"),
+		8,
+		TEXT("How many ring VFX may simulate at once, the rest are paused or deactivated by distance"));
+
+	//Significance is cheap but doesn't need to follow the player every frame
+	constexpr float SignificanceInterval = 0.25f;
+}
 
 // Sets default values
 ARingManager::ARingManager()
@@ -11,6 +39,97 @@ ARingManager::ARingManager()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	RingInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("RingInstances"));
+	RingInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RingInstances->NumCustomDataFloats = 1;
+	RootComponent = RingInstances;
+
+	ActiveRingInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("ActiveRingInstances"));
+	ActiveRingInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ActiveRingInstances->NumCustomDataFloats = 1;
+	ActiveRingInstances->SetupAttachment(RingInstances);
+
+	//Ring state is derived from the replicated player progress on every machine
+	bReplicates = false;
+
+#if WITH_EDITORONLY_DATA
+	//The manager drives streaming, it can't be streamed out itself
+	bIsSpatiallyLoaded = false;
+#endif
+}
+
+void ARingManager::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+#if WITH_EDITOR
+	CacheRingLocations();
+#endif
+}
+
+#if WITH_EDITOR
+void ARingManager::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	if (!UsesCourse())
+	{
+		CacheRingLocations();
+		ValidateRingCache();
+	}
+}
+
+void ARingManager::OnRingMoved(ARing* Ring)
+{
+	const int32 Index = RingArray.IndexOfByPredicate([Ring](const TSoftObjectPtr<ARing>& Entry) { return Entry.Get() == Ring; });
+	if (Index == INDEX_NONE) return;
+
+	Modify();
+	RingLocations.SetNumZeroed(RingArray.Num());
+	RingRadii.SetNumZeroed(RingArray.Num());
+	RingLocations[Index] = Ring->GetActorLocation();
+	RingRadii[Index] = Ring->GetCollectRadius();
+}
+#endif
+
+void ARingManager::CacheRingLocations()
+{
+	//Rings that aren't loaded keep what was cached last time they were, new entries stay uncached until they load
+	RingLocations.SetNumZeroed(RingArray.Num());
+	RingRadii.SetNumZeroed(RingArray.Num());
+	for (int32 Index = 0; Index < RingArray.Num(); ++Index)
+	{
+		if (const ARing* Ring = RingArray[Index].Get())
+		{
+			RingLocations[Index] = Ring->GetActorLocation();
+			RingRadii[Index] = Ring->GetCollectRadius();
+		}
+	}
+}
+
+bool ARingManager::IsRingCached(int32 Index) const
+{
+	return RingRadii.IsValidIndex(Index) && RingRadii[Index] > 0.f;
+}
+
+bool ARingManager::ValidateRingCache() const
+{
+	bool bValid = true;
+	for (int32 Index = 0; Index < RingArray.Num(); ++Index)
+	{
+		if (!IsRingCached(Index))
+		{
+			UE_LOG(LogSkateBGS, Error, TEXT("%s: ring %d (%s) has no cached location, load it and resave the level"),
+				*GetName(), Index, *RingArray[Index].ToString());
+			bValid = false;
+		}
+	}
+	return bValid;
+}
+
+ARing* ARingManager::GetRing(int32 Index) const
+{
+	return RingArray.IsValidIndex(Index) ? RingArray[Index].Get() : nullptr;
 }
 
 // Called when the game starts or when spawned
@@ -18,66 +137,587 @@ void ARingManager::BeginPlay()
 {
 	Super::BeginPlay();
 
-	AActor* Actor = UGameplayStatics::GetActorOfClass(GetWorld(), ASkateCharacter::StaticClass());
-	if (Actor)
+	SetPlayerRef(Cast<ASkateCharacter>(UGameplayStatics::GetActorOfClass(GetWorld(), ASkateCharacter::StaticClass())));
+	if (!UsesCourse() && (RingLocations.Num() != RingArray.Num() || RingRadii.Num() != RingArray.Num()))
+	{
+		//Not saved since the cache was added, rings that aren't loaded are left out until they stream in
+		CacheRingLocations();
+	}
+	if (!UsesCourse())
+	{
+		ValidateRingCache();
+		BuildRingIndices();
+	}
+	BuildRingGrid();
+	CollectedRings.Init(false, NumRings());
+	BuildRingInstances();
+	InitializeRings();
+
+	if (URingSubsystem* Rings = GetWorld()->GetSubsystem<URingSubsystem>())
 	{
-		PlayerRef = Cast<ASkateCharacter>(Actor);
-		if (PlayerRef)
+		Rings->RegisterManager(this);
+	}
+
+	if (UWorldPartitionSubsystem* WorldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+	{
+		if (!UsesCourse())
 		{
-			PlayerRef->RingCollected.AddDynamic(this, &ARingManager::SetNextRing);
+			WorldPartition->RegisterStreamingSourceProvider(this);
 		}
+	}
 
+	USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>();
+	if (Effects && UsesCourse())
+	{
+		Effects->Prewarm(OverlapEffect);
+		Effects->Prewarm(OverlapSound);
+	}
+
+	if (!UsesCourse() && RingArray.Num() > 0 && GetNetMode() != NM_DedicatedServer)
+	{
+		GetWorldTimerManager().SetTimer(SignificanceTimer, this, &ARingManager::UpdateSignificance, SignificanceInterval, true, 0.f);
 	}
-	InitializeRings();
 
 	
 }
 
+void ARingManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (URingSubsystem* Rings = GetWorld()->GetSubsystem<URingSubsystem>())
+	{
+		Rings->UnregisterManager(this);
+	}
+	if (UWorldPartitionSubsystem* WorldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+	{
+		WorldPartition->UnregisterStreamingSourceProvider(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ARingManager::GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const
+{
+	if (UsesCourse()) return false;
+
+	//Player streaming covers where they are, this covers where the course sends them next.
+	//An uncached ring has no known location yet, ValidateRingCache already reported it
+	const int32 LastRing = FMath::Min(RingIndex + RingsStreamedAhead, RingLocations.Num());
+	bool bAddedSource = false;
+	for (int32 Index = RingIndex; Index < LastRing; ++Index)
+	{
+		if (!IsRingCached(Index)) continue;
+
+		bAddedSource = true;
+		FWorldPartitionStreamingSource& Source = OutStreamingSources.AddDefaulted_GetRef();
+		Source.Name = GetFName();
+		Source.Location = RingLocations[Index];
+		Source.Rotation = FRotator::ZeroRotator;
+		Source.TargetState = EStreamingSourceTargetState::Activated;
+
+		FStreamingSourceShape& Shape = Source.Shapes.AddDefaulted_GetRef();
+		Shape.bUseGridLoadingRange = false;
+		Shape.Radius = RingStreamingRadius;
+	}
+	return bAddedSource;
+}
+
+void ARingManager::OnRingLoaded(ARing* Ring)
+{
+	if (!HasActorBegunPlay() || UsesCourse()) return;
+
+	//Rings with no entry aren't part of the course, same named rings in different levels share a key and need the search
+	const int32* FoundIndex = RingIndices.Find(Ring->GetFName());
+	if (!FoundIndex) return;
+
+	const int32 Index = RingArray[*FoundIndex].Get() == Ring
+		? *FoundIndex
+		: RingArray.IndexOfByPredicate([Ring](const TSoftObjectPtr<ARing>& Entry) { return Entry.Get() == Ring; });
+	if (Index == INDEX_NONE) return;
+
+	if (!IsRingCached(Index))
+	{
+		RingLocations[Index] = Ring->GetActorLocation();
+		RingRadii[Index] = Ring->GetCollectRadius();
+		bRingGridDirty = true;
+	}
+
+	if (CollectedRings[Index])
+	{
+		SetRingState(Index, ERingState::Collected);
+	}
+	else if (Index == RingIndex)
+	{
+		SetRingState(Index, ERingState::Active);
+	}
+	else if (Index == RingIndex + 1)
+	{
+		SetRingState(Index, ERingState::Upcoming);
+	}
+	else
+	{
+		SetRingState(Index, ERingState::Hidden);
+	}
+}
+
 // Called every frame
 void ARingManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	//Rings that streamed in since the last frame, however many, cost one rebuild
+	if (bRingGridDirty)
+	{
+		BuildRingGrid();
+		bRingGridDirty = false;
+	}
+
+	DetectCollection();
+
+	//Course rings bob on the CPU like hand placed ones, only the visible few have instances to move
+	if (UsesCourse() && CourseBobAmplitude != 0.f && GetNetMode() != NM_DedicatedServer)
+	{
+		UpdateCourseInstances();
+	}
 }
 
-void ARingManager::SetNextRing()
+void ARingManager::SetPlayerRef(ASkateCharacter* Player)
 {
-	if (RingIndex + 1 >= RingArray.Num()) return;
+	if (Player == PlayerRef) return;
 
-	RingIndex += 1;
+	if (PlayerRef)
+	{
+		PlayerRef->RingCollected.RemoveDynamic(this, &ARingManager::SetNextRing);
+		RemoveTickPrerequisiteActor(PlayerRef);
+	}
 
-	if (RingArray[RingIndex])
+	PlayerRef = Player;
+	if (PlayerRef)
 	{
-		ARing* Ring = RingArray[RingIndex];
-		Ring->SetRingActive();
+		PlayerRef->RingCollected.AddDynamic(this, &ARingManager::SetNextRing);
+
+		//Test against where the player ended up this frame
+		AddTickPrerequisiteActor(PlayerRef);
+	}
+}
+
+void ARingManager::BindLocalPlayer()
+{
+	//A dedicated server has no local player, its first player controller belongs to a remote client
+	if (GetNetMode() == NM_DedicatedServer) return;
 
-		if (Ring != RingArray.Last() && RingArray[RingIndex + 1])
+	//Possession and player states arrive after BeginPlay on clients, and the pawn changes on respawn
+	APlayerController* Controller = GEngine->GetFirstLocalPlayerController(GetWorld());
+	if (!Controller) return;
+
+	if (ASkateCharacter* Player = Controller->GetPawn<ASkateCharacter>())
+	{
+		SetPlayerRef(Player);
+	}
+
+	if (!LocalPlayerState)
+	{
+		LocalPlayerState = Controller->GetPlayerState<ASkatePlayerState>();
+		if (LocalPlayerState)
 		{
-			Ring = RingArray[RingIndex+1];
-			Ring->Mesh->SetVisibility(true);
+			LocalPlayerState->OnRingProgressChanged.AddUObject(this, &ARingManager::OnLocalRingProgress);
 		}
 	}
+
+	//Joined mid course, or progress arrived before the pawn did
+	if (LocalPlayerState && PlayerRef && RingIndex < FMath::Min(LocalPlayerState->GetRingIndex(), NumRings()))
+	{
+		OnLocalRingProgress(RingIndex, LocalPlayerState->GetRingIndex());
+	}
 }
 
-void ARingManager::InitializeRings()
+bool ARingManager::UsesCourse() const
 {
-	for (ARing* Ring : RingArray)
+	return Course != nullptr;
+}
+
+int32 ARingManager::NumRings() const
+{
+	return UsesCourse() ? Course->Rings.Num() : RingArray.Num();
+}
+
+void ARingManager::BuildRingIndices()
+{
+	//Keyed by the ring's object name, which the soft reference keeps through streaming and PIE renames
+	RingIndices.Reset();
+	RingIndices.Reserve(RingArray.Num());
+	for (int32 Index = 0; Index < RingArray.Num(); ++Index)
 	{
-		Ring->SetRingInactive();
-		Ring->Mesh->SetVisibility(false);
+		const FString& SubPath = RingArray[Index].ToSoftObjectPath().GetSubPathString();
+		int32 NameStart = INDEX_NONE;
+		SubPath.FindLastChar(TEXT('.'), NameStart);
+		RingIndices.FindOrAdd(FName(*SubPath.Mid(NameStart + 1)), Index);
 	}
+}
 
-	if (RingArray[0])
+void ARingManager::BuildRingGrid()
+{
+	RingGrid.Reset();
+	if (UsesCourse())
+	{
+		for (const FRingCourseEntry& Entry : Course->Rings)
+		{
+			RingGrid.AddRing(Entry.Location, Entry.Radius);
+		}
+	}
+	else
 	{
-		ARing* Ring = RingArray[0];
+		//Uses the cache so rings that aren't streamed in can still be collected
+		for (int32 Index = 0; Index < RingLocations.Num(); ++Index)
+		{
+			RingGrid.AddRing(RingLocations[Index], RingRadii[Index]);
+		}
+	}
+	RingGrid.Build();
+}
+
+void ARingManager::BuildRingInstances()
+{
+	RingInstances->ClearInstances();
+	ActiveRingInstances->ClearInstances();
+	ActiveCourseRings.Reset();
+	UpcomingCourseRings.Reset();
+	if (!UsesCourse()) return;
+
+	ActiveRingInstances->SetStaticMesh(RingInstances->GetStaticMesh());
+	if (ActiveRingMaterial)
+	{
+		ActiveRingInstances->SetMaterial(0, ActiveRingMaterial);
+	}
+	if (UpcomingRingMaterial)
+	{
+		RingInstances->SetMaterial(0, UpcomingRingMaterial);
+	}
+}
+
+void ARingManager::UpdateCourseInstances()
+{
+	//A couple of rings are visible at a time, their instances are moved in place rather than rebuilt
+	const float Time = GetWorld()->GetTimeSeconds();
+	auto UpdateInstances = [this, Time](UInstancedStaticMeshComponent* Instances, const TArray<int32>& CourseRings)
+	{
+		for (int32 Instance = 0; Instance < CourseRings.Num(); ++Instance)
+		{
+			const FRingCourseEntry& Entry = Course->Rings[CourseRings[Instance]];
+			const FVector Bob(0.f, 0.f, CourseBobAmplitude * FMath::Sin((Time + Entry.TimeOffset) * CourseBobPeriod));
+			const FTransform Transform(Entry.Rotation, Entry.Location + Bob);
+			if (Instance < Instances->GetInstanceCount())
+			{
+				Instances->UpdateInstanceTransform(Instance, Transform, true, false, true);
+			}
+			else
+			{
+				Instances->AddInstance(Transform, true);
+			}
+			Instances->SetCustomDataValue(Instance, 0, Entry.TimeOffset, false);
+		}
+		while (Instances->GetInstanceCount() > CourseRings.Num())
+		{
+			Instances->RemoveInstance(Instances->GetInstanceCount() - 1);
+		}
+		Instances->MarkRenderStateDirty();
+	};
+	UpdateInstances(RingInstances, UpcomingCourseRings);
+	UpdateInstances(ActiveRingInstances, ActiveCourseRings);
+}
+
+void ARingManager::SetRingState(int32 Index, ERingState State)
+{
+	if (UsesCourse())
+	{
+		ActiveCourseRings.Remove(Index);
+		UpcomingCourseRings.Remove(Index);
+		if (State == ERingState::Active)
+		{
+			ActiveCourseRings.Add(Index);
+		}
+		else if (State == ERingState::Upcoming)
+		{
+			UpcomingCourseRings.Add(Index);
+		}
+
+		//Instances are updated once by the caller after all of its state changes
+		return;
+	}
+
+	//Rings that aren't streamed in get their state from OnRingLoaded
+	ARing* Ring = GetRing(Index);
+	if (!Ring) return;
+
+	switch (State)
+	{
+	case ERingState::Hidden:
+		Ring->SetRingInactive();
+		Ring->Mesh->SetVisibility(false);
+		break;
+	case ERingState::Upcoming:
+		Ring->SetRingInactive();
 		Ring->Mesh->SetVisibility(true);
+		break;
+	case ERingState::Active:
 		Ring->SetRingActive();
+		Ring->Mesh->SetVisibility(true);
+		break;
+	case ERingState::Collected:
+		Ring->SetRingCollected();
+		break;
+	}
+}
+
+void ARingManager::DetectCollection()
+{
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateRingDetection);
+	BindLocalPlayer();
+
+	//Clients only follow the replicated progress
+	if (GetNetMode() == NM_Client) return;
+
+	//Skaters without a skate player state keep their progress local to this manager
+	if (PlayerRef && !PlayerRef->GetPlayerState<ASkatePlayerState>())
+	{
+		//Sweep from last frame's location so fast skaters can't pass through a ring between frames
+		const FVector PlayerLocation = PlayerRef->GetActorLocation();
+		const FVector SegmentStart = bHasLastPlayerLocation ? LastPlayerLocation : PlayerLocation;
+		LastPlayerLocation = PlayerLocation;
+		bHasLastPlayerLocation = true;
+
+		const int32 Hit = SweepForRing(PlayerRef, SegmentStart, RingIndex);
+		if (Hit != INDEX_NONE && !CollectedRings[Hit])
+		{
+			CollectRing(Hit);
+		}
+	}
+
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	if (!GameState) return;
+
+	for (APlayerState* PlayerState : GameState->PlayerArray)
+	{
+		ASkatePlayerState* SkateState = Cast<ASkatePlayerState>(PlayerState);
+		ASkateCharacter* Skater = SkateState ? SkateState->GetPawn<ASkateCharacter>() : nullptr;
+		if (!Skater) continue;
+
+		const FVector SkaterLocation = Skater->GetActorLocation();
+		FVector& LastLocation = LastSkaterLocations.FindOrAdd(TWeakObjectPtr<const AActor>(Skater), SkaterLocation);
+		const int32 Hit = SweepForRing(Skater, LastLocation, SkateState->GetRingIndex());
+		LastLocation = SkaterLocation;
+
+		//Only the player's next ring can be taken, and only from where the server has them
+		if (Hit != INDEX_NONE)
+		{
+			SkateState->SetRingIndex(Hit + 1);
+
+			//The local player collects through OnLocalRingProgress, remote players' skaters still count
+			//the ring here so the server runs their ring count and victory
+			if (SkateState != LocalPlayerState)
+			{
+				Skater->CollectRing();
+			}
+		}
+	}
+
+	//Skaters that left or respawned
+	if (LastSkaterLocations.Num() > GameState->PlayerArray.Num())
+	{
+		for (auto It = LastSkaterLocations.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+int32 ARingManager::SweepForRing(const ASkateCharacter* Skater, const FVector& SegmentStart, int32 NextRingIndex) const
+{
+	if (NextRingIndex >= NumRings()) return INDEX_NONE;
+
+	const float SkaterRadius = Skater->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	return RingGrid.FindRing(SegmentStart, Skater->GetActorLocation(), SkaterRadius, [this, NextRingIndex](int32 Index)
+	{
+		//Uncached rings are left at the origin, they can't be taken until they stream in
+		return Index == NextRingIndex && (UsesCourse() || IsRingCached(Index));
+	});
+}
+
+void ARingManager::OnLocalRingProgress(int32 OldRingIndex, int32 NewRingIndex)
+{
+	if (NewRingIndex < OldRingIndex)
+	{
+		ResetRings();
+	}
+
+	//Plays the pickups and moves the active ring along, one ring at a time in case several arrived together
+	const int32 LastRing = FMath::Min(NewRingIndex, NumRings());
+	for (int32 Index = RingIndex; Index < LastRing; ++Index)
+	{
+		if (!CollectedRings[Index] && PlayerRef)
+		{
+			CollectRing(Index);
+		}
+	}
+}
+
+void ARingManager::CollectRing(int32 Index)
+{
+	if (!UsesCourse())
+	{
+		if (ARing* Ring = GetRing(Index))
+		{
+			Ring->Collect(PlayerRef);
+		}
+		else
+		{
+			PlayerRef->CollectRing();
+		}
+		return;
+	}
+
+	const FVector Location = Course->Rings[Index].Location;
+	if (USkateEffectsSubsystem* Effects = GetWorld()->GetSubsystem<USkateEffectsSubsystem>())
+	{
+		Effects->PlayEffect(OverlapEffect, Location);
+		Effects->PlaySound(OverlapSound, Location);
+	}
+	PlayerRef->CollectRing();
+}
+
+void ARingManager::SetNextRing()
+{
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateSetNextRing);
+	if (CollectedRings.IsValidIndex(RingIndex))
+	{
+		CollectedRings[RingIndex] = true;
+		SetRingState(RingIndex, ERingState::Collected);
+	}
+
+	if (RingIndex + 1 >= NumRings()) return;
+
+	RingIndex += 1;
+	SetRingState(RingIndex, ERingState::Active);
+
+	if (RingIndex + 1 < NumRings())
+	{
+		SetRingState(RingIndex + 1, ERingState::Upcoming);
+	}
+
+	if (UsesCourse())
+	{
+		UpdateCourseInstances();
+	}
+}
+
+void ARingManager::UpdateSignificance()
+{
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateRingSignificance);
+	if (!PlayerRef) return;
+
+	const FVector PlayerLocation = PlayerRef->GetActorLocation();
+	SignificanceOrder.Reset();
+	for (int32 Index = 0; Index < RingArray.Num(); ++Index)
+	{
+		const ARing* Ring = GetRing(Index);
+		if (!Ring || CollectedRings[Index]) continue;
+
+		//The active and upcoming rings always come first, then the rest by distance
+		const float DistanceSquared = FVector::DistSquared(Ring->GetActorLocation(), PlayerLocation);
+		const float Score = Index <= RingIndex + 1 ? -1.f / (1.f + DistanceSquared) : DistanceSquared;
+		SignificanceOrder.Emplace(Score, Index);
+	}
+	SignificanceOrder.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	const int32 Budget = FMath::Max(0, CVarMaxActiveRingVFX.GetValueOnGameThread());
+	for (int32 Rank = 0; Rank < SignificanceOrder.Num(); ++Rank)
+	{
+		ARing* Ring = GetRing(SignificanceOrder[Rank].Value);
+		const float DistanceSquared = FVector::DistSquared(Ring->GetActorLocation(), PlayerLocation);
+
+		ERingEffectLevel Level = ERingEffectLevel::Off;
+		if (Rank < Budget)
+		{
+			Level = DistanceSquared < FMath::Square(FullEffectDistance) ? ERingEffectLevel::Full : ERingEffectLevel::Reduced;
+		}
+		else if (DistanceSquared < FMath::Square(PausedEffectDistance))
+		{
+			Level = ERingEffectLevel::Paused;
+		}
+		Ring->SetEffectLevel(Level);
+	}
+}
+
+void ARingManager::ResetCourse()
+{
+	if (LocalPlayerState)
+	{
+		//Setting the progress back calls OnLocalRingProgress on every machine
+		if (LocalPlayerState->HasAuthority())
+		{
+			LocalPlayerState->SetRingIndex(0);
+		}
+		return;
+	}
+	ResetRings();
+}
 
-		if (RingArray[RingIndex + 1])
+void ARingManager::ResetRings()
+{
+	//Collected rings stay hidden in place, rings that are streamed out come back fresh anyway
+	for (const TSoftObjectPtr<ARing>& RingPtr : RingArray)
+	{
+		ARing* Ring = RingPtr.Get();
+		if (Ring && Ring->IsCollected())
 		{
-			Ring = RingArray[RingIndex + 1];
-			Ring->Mesh->SetVisibility(true);
+			Ring->ResetRing();
 		}
 	}
+	CollectedRings.Init(false, NumRings());
+
+	RingIndex = 0;
+	bHasLastPlayerLocation = false;
+	LastSkaterLocations.Reset();
+	InitializeRings();
+
+	if (PlayerRef)
+	{
+		PlayerRef->ResetRingCount();
+	}
 }
 
+void ARingManager::InitializeRings()
+{
+	if (UsesCourse())
+	{
+		ActiveCourseRings.Reset();
+		UpcomingCourseRings.Reset();
+	}
+	else
+	{
+		for (int32 Index = 0; Index < NumRings(); ++Index)
+		{
+			SetRingState(Index, ERingState::Hidden);
+		}
+	}
+
+	if (NumRings() > 0)
+	{
+		SetRingState(0, ERingState::Active);
+
+		if (NumRings() > 1)
+		{
+			SetRingState(1, ERingState::Upcoming);
+		}
+	}
+
+	if (UsesCourse())
+	{
+		UpdateCourseInstances();
+	}
+}
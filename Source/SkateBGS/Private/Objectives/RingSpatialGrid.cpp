@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Objectives/RingSpatialGrid.h"
+
+namespace
+{
+	//Keeps the grid memory bounded for sparse or very large courses
+	constexpr int32 MaxCellsPerRing = 4;
+}
+
+void FRingSpatialGrid::Reset()
+{
+	Centers.Reset();
+	Radii.Reset();
+	CellStarts.Reset();
+	CellRings.Reset();
+	MaxRadius = 0.f;
+	CellsX = 0;
+	CellsY = 0;
+}
+
+int32 FRingSpatialGrid::AddRing(const FVector& Center, float Radius)
+{
+	MaxRadius = FMath::Max(MaxRadius, Radius);
+	Radii.Add(Radius);
+	return Centers.Add(Center);
+}
+
+FIntPoint FRingSpatialGrid::GetCell(const FVector2D& Location) const
+{
+	const FVector2D Local = (Location - GridOrigin) / CellSize;
+	return FIntPoint(
+		FMath::Clamp(FMath::FloorToInt32(Local.X), 0, CellsX - 1),
+		FMath::Clamp(FMath::FloorToInt32(Local.Y), 0, CellsY - 1));
+}
+
+void FRingSpatialGrid::Build(float MinCellSize)
+{
+	CellStarts.Reset();
+	CellRings.Reset();
+	if (Centers.Num() == 0) return;
+
+	FBox2D Bounds(ForceInit);
+	for (const FVector& Center : Centers)
+	{
+		Bounds += FVector2D(Center);
+	}
+	Bounds = Bounds.ExpandBy(MaxRadius);
+
+	//Cells at least as big as a ring, and big enough that the cell count stays proportional to the ring count
+	const FVector2D Size = Bounds.GetSize();
+	const float AreaCellSize = FMath::Sqrt(Size.X * Size.Y / (Centers.Num() * MaxCellsPerRing));
+	CellSize = FMath::Max3(MinCellSize, MaxRadius * 2.f, AreaCellSize);
+	GridOrigin = Bounds.Min;
+	CellsX = FMath::Max(1, FMath::CeilToInt32(Size.X / CellSize));
+	CellsY = FMath::Max(1, FMath::CeilToInt32(Size.Y / CellSize));
+
+	//Counting sort: count rings per cell, prefix sum, then fill
+	CellStarts.SetNumZeroed(CellsX * CellsY + 1);
+	auto ForEachCell = [this](int32 Ring, TFunctionRef<void(int32)> Visit)
+	{
+		const FVector2D Center(Centers[Ring]);
+		const FIntPoint Min = GetCell(Center - Radii[Ring]);
+		const FIntPoint Max = GetCell(Center + Radii[Ring]);
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			for (int32 X = Min.X; X <= Max.X; ++X)
+			{
+				Visit(Y * CellsX + X);
+			}
+		}
+	};
+
+	for (int32 Ring = 0; Ring < Centers.Num(); ++Ring)
+	{
+		ForEachCell(Ring, [this](int32 Cell) { CellStarts[Cell + 1] += 1; });
+	}
+	for (int32 Cell = 1; Cell < CellStarts.Num(); ++Cell)
+	{
+		CellStarts[Cell] += CellStarts[Cell - 1];
+	}
+
+	CellRings.SetNumUninitialized(CellStarts.Last());
+	TArray<int32> Cursor(CellStarts.GetData(), CellStarts.Num() - 1);
+	for (int32 Ring = 0; Ring < Centers.Num(); ++Ring)
+	{
+		ForEachCell(Ring, [this, Ring, &Cursor](int32 Cell) { CellRings[Cursor[Cell]++] = Ring; });
+	}
+}
+
+int32 FRingSpatialGrid::FindRing(const FVector& Start, const FVector& End, float ExtraRadius, TFunctionRef<bool(int32)> Filter) const
+{
+	if (CellRings.Num() == 0) return INDEX_NONE;
+
+	//Every cell the segment's XY bounds touch, grown by the skater radius
+	FBox2D SegmentBounds(ForceInit);
+	SegmentBounds += FVector2D(Start);
+	SegmentBounds += FVector2D(End);
+	SegmentBounds = SegmentBounds.ExpandBy(ExtraRadius);
+	const FIntPoint Min = GetCell(SegmentBounds.Min);
+	const FIntPoint Max = GetCell(SegmentBounds.Max);
+
+	int32 Found = INDEX_NONE;
+	for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+	{
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			const int32 Cell = Y * CellsX + X;
+			for (int32 Slot = CellStarts[Cell]; Slot < CellStarts[Cell + 1]; ++Slot)
+			{
+				const int32 Ring = CellRings[Slot];
+				if (Found != INDEX_NONE && Ring >= Found) continue;
+
+				const float Radius = Radii[Ring] + ExtraRadius;
+				if (FMath::PointDistToSegmentSquared(Centers[Ring], Start, End) <= Radius * Radius && Filter(Ring))
+				{
+					Found = Ring;
+				}
+			}
+		}
+	}
+	return Found;
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Objectives/RingSubsystem.h"
+#include "Objectives/RingManager.h"
+#include "SkateBGSLog.h"
+
+bool URingSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void URingSubsystem::RegisterManager(ARingManager* InManager)
+{
+	if (Manager.IsValid() && Manager.Get() != InManager)
+	{
+		UE_LOG(LogSkateBGS, Warning, TEXT("%s replaces %s as the ring manager, only one manager per world is supported"), *GetNameSafe(InManager), *Manager->GetName());
+	}
+	Manager = InManager;
+}
+
+void URingSubsystem::UnregisterManager(ARingManager* InManager)
+{
+	if (Manager.Get() == InManager)
+	{
+		Manager.Reset();
+	}
+}
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Tests/SkateTestWorld.h"
+#include "Characters/SkateCharacter.h"
+#include "Objectives/Ring.h"
+#include "Objectives/RingManager.h"
+
+namespace
+{
+	constexpr int32 NumTestRings = 33;
+	constexpr float TestRingSpacing = 1000.f;
+	constexpr float TestFrameTime = 1.f / 60.f;
+
+	ASkateCharacter* SpawnTestSkater(UWorld* World)
+	{
+		const FTransform Transform(FVector(-TestRingSpacing, 0.f, 0.f));
+		ASkateCharacter* Skater = World->SpawnActorDeferred<ASkateCharacter>(ASkateCharacter::StaticClass(), Transform);
+		Skater->bCreateHUD = false;
+		Skater->FinishSpawning(Transform);
+		return Skater;
+	}
+
+	void SpawnTestRings(UWorld* World, TArray<ARing*>& OutRings)
+	{
+		OutRings.Reset();
+		for (int32 Index = 0; Index < NumTestRings; ++Index)
+		{
+			OutRings.Add(World->SpawnActor<ARing>(ARing::StaticClass(), FTransform(FVector(Index * TestRingSpacing, 0.f, 0.f))));
+		}
+	}
+
+	/** Teleports the skater through every ring of the course, returns the worst frame in milliseconds */
+	double RunCourse(FSkateTestWorld& TestWorld, ASkateCharacter* Skater, TFunctionRef<void(int32)> OnRingPassed)
+	{
+		double WorstFrame = 0.0;
+		for (int32 Index = 0; Index < NumTestRings; ++Index)
+		{
+			const double Start = FPlatformTime::Seconds();
+			Skater->SetActorLocation(FVector(Index * TestRingSpacing, 0.f, 0.f), false, nullptr, ETeleportType::TeleportPhysics);
+			TestWorld.Tick(TestFrameTime);
+			OnRingPassed(Index);
+			WorstFrame = FMath::Max(WorstFrame, (FPlatformTime::Seconds() - Start) * 1000.0);
+		}
+		return WorstFrame;
+	}
+
+	/** Runs a full garbage collection, returns how long it took in milliseconds and how many objects it purged */
+	double TimeGarbageCollection(int32& OutPurged)
+	{
+		const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		const double Start = FPlatformTime::Seconds();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		OutPurged = ObjectsBefore - GUObjectArray.GetObjectArrayNumMinusAvailable();
+		return (FPlatformTime::Seconds() - Start) * 1000.0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateRingPoolTest, "SkateBGS.Rings.PoolWithoutGarbage",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSkateRingPoolTest::RunTest(const FString& Parameters)
+{
+	int32 Purged = 0;
+
+	//Baseline: rings destroyed as they are collected and spawned again for the next run, as before pooling
+	double DestroyWorstMs = 0.0;
+	double DestroyGCMs = 0.0;
+	int32 DestroyPurged = 0;
+	{
+		FSkateTestWorld TestWorld;
+		UWorld* World = TestWorld.Get();
+		ASkateCharacter* Skater = SpawnTestSkater(World);
+		TArray<ARing*> Rings;
+		SpawnTestRings(World, Rings);
+
+		TestWorld.Tick(TestFrameTime);
+		TimeGarbageCollection(Purged);
+
+		auto DestroyRing = [&Rings](int32 Index) { Rings[Index]->Destroy(); };
+		DestroyWorstMs = RunCourse(TestWorld, Skater, DestroyRing);
+		SpawnTestRings(World, Rings);
+		DestroyWorstMs = FMath::Max(DestroyWorstMs, RunCourse(TestWorld, Skater, DestroyRing));
+
+		DestroyGCMs = TimeGarbageCollection(DestroyPurged);
+	}
+
+	//Pooled: two full runs with a reset in between, the second one reuses the same rings
+	FSkateTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	ASkateCharacter* Skater = SpawnTestSkater(World);
+
+	ARingManager* Manager = World->SpawnActorDeferred<ARingManager>(ARingManager::StaticClass(), FTransform::Identity);
+	TArray<ARing*> Rings;
+	SpawnTestRings(World, Rings);
+	for (ARing* Ring : Rings)
+	{
+		Manager->RingArray.Add(Ring);
+	}
+	Manager->FinishSpawning(FTransform::Identity);
+
+	TestWorld.Tick(TestFrameTime);
+	const int32 ActorsBefore = TestWorld.CountActors();
+	TimeGarbageCollection(Purged);
+	const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+	auto KeepRing = [](int32 Index) {};
+	const double FirstRunWorstMs = RunCourse(TestWorld, Skater, KeepRing);
+	for (const ARing* Ring : Rings)
+	{
+		TestTrue(TEXT("Collected rings are pooled, not destroyed"), IsValid(Ring) && Ring->IsCollected());
+	}
+
+	Manager->ResetCourse();
+	for (const ARing* Ring : Rings)
+	{
+		TestTrue(TEXT("Reset re-arms every ring in place"), IsValid(Ring) && !Ring->IsCollected());
+	}
+	const double PooledWorstMs = FMath::Max(FirstRunWorstMs, RunCourse(TestWorld, Skater, KeepRing));
+
+	TestEqual(TEXT("Running and resetting the course spawns and destroys no actors"), TestWorld.CountActors(), ActorsBefore);
+
+	int32 PooledPurged = 0;
+	const double PooledGCMs = TimeGarbageCollection(PooledPurged);
+	const int32 ObjectsAfter = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+	for (const ARing* Ring : Rings)
+	{
+		TestTrue(TEXT("Rings survive garbage collection"), IsValid(Ring));
+	}
+	TestTrue(TEXT("Pooled runs leave no more live objects than they started with"), ObjectsAfter <= ObjectsBefore);
+	TestTrue(TEXT("Pooled runs leave less garbage than destroying rings"), PooledPurged < DestroyPurged);
+
+	AddInfo(FString::Printf(TEXT("Destroy on collect: worst frame %.2f ms, GC %.2f ms purging %d objects"), DestroyWorstMs, DestroyGCMs, DestroyPurged));
+	AddInfo(FString::Printf(TEXT("Pooled: worst frame %.2f ms, GC %.2f ms purging %d objects, live objects %d -> %d"), PooledWorstMs, PooledGCMs, PooledPurged, ObjectsBefore, ObjectsAfter));
+	return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Tests/SkateTestWorld.h"
+#include "Benchmark/SkateBenchmarkSubsystem.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	constexpr int32 TestSkaters = 4;
+	constexpr int32 TestFrames = 60;
+	constexpr int32 TestRings = 16;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateBenchmarkTest, "SkateBGS.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSkateBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FSkateTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+
+	USkateBenchmarkSubsystem* Benchmark = World->GetSubsystem<USkateBenchmarkSubsystem>();
+	if (!TestNotNull(TEXT("Game worlds have a benchmark subsystem"), Benchmark)) return false;
+
+	const int32 ActorsBefore = TestWorld.CountActors();
+	Benchmark->StartBenchmark(TestSkaters, TestFrames, TestRings);
+	TestTrue(TEXT("Benchmark started"), Benchmark->IsRunning());
+
+	//A few spare frames in case the run doesn't finish on time
+	for (int32 Frame = 0; Frame < TestFrames + 10 && Benchmark->IsRunning(); ++Frame)
+	{
+		TestWorld.Tick(1.f / 60.f);
+	}
+	TestFalse(TEXT("Benchmark finished after its frames"), Benchmark->IsRunning());
+
+	TestEqual(TEXT("Skaters, controllers and the ring manager are destroyed when the run finishes"), TestWorld.CountActors(), ActorsBefore);
+
+	TArray<FString> Lines;
+	if (TestTrue(TEXT("CSV written"), FFileHelper::LoadFileToStringArray(Lines, *Benchmark->GetLastCsvPath())))
+	{
+		TestEqual(TEXT("One header and one row per frame"), Lines.Num(), TestFrames + 1);
+		TestTrue(TEXT("Allocations are counted"), Lines[0].EndsWith(TEXT(",Allocs")));
+		AddInfo(FString::Printf(TEXT("Wrote %s"), *Benchmark->GetLastCsvPath()));
+	}
+	return true;
+}
+
+#endif
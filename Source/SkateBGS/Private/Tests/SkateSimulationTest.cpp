@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Characters/SkateSimulation.h"
+
+namespace
+{
+	constexpr uint32 SkateSimTestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+	/** Runs StepBoost for Duration seconds at Hz */
+	FSkateSimState RunBoost(FSkateSimState State, const FSkateSimParams& Params, float Speed, float Duration, int32 Hz)
+	{
+		const int32 Steps = FMath::RoundToInt(Duration * Hz);
+		for (int32 Index = 0; Index < Steps; ++Index)
+		{
+			SkateSim::StepBoost(State, Params, Speed, 1.f / Hz);
+		}
+		return State;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateSimDecelerationTest, "SkateBGS.Simulation.GetDecelerationScale", SkateSimTestFlags)
+
+bool FSkateSimDecelerationTest::RunTest(const FString& Parameters)
+{
+	const FSkateSimParams Params;
+	TestEqual(TEXT("Slow skaters keep the full push"), SkateSim::GetDecelerationScale(Params, 300.f, 0.f), 1.f);
+	TestEqual(TEXT("Pushing forward keeps the full push"), SkateSim::GetDecelerationScale(Params, 800.f, 1.f), 1.f);
+	TestEqual(TEXT("Coasting eases off by the deceleration rate"), SkateSim::GetDecelerationScale(Params, 800.f, 0.f), 0.2f, KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("Coasting above regular speed scales with speed"), SkateSim::GetDecelerationScale(Params, 1200.f, 0.f), 30.f / (5.f * 1200.f), KINDA_SMALL_NUMBER);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateSimDecayAlphaTest, "SkateBGS.Simulation.GetDecayAlpha", SkateSimTestFlags)
+
+bool FSkateSimDecayAlphaTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("One 60 Hz step is the step alpha"), SkateSim::GetDecayAlpha(0.05f, 1.f / 60.f), 0.05f, KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("No time is no decay"), SkateSim::GetDecayAlpha(0.05f, 0.f), 0.f, KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("Two 60 Hz steps in one tick"), SkateSim::GetDecayAlpha(0.5f, 1.f / 30.f), 0.75f, KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("Alpha is clamped"), SkateSim::GetDecayAlpha(2.f, 1.f / 60.f), 1.f, KINDA_SMALL_NUMBER);
+
+	//Lerping towards a target at any tick rate covers the same distance in the same time
+	for (const int32 Hz : { 30, 120, 144 })
+	{
+		float Value = 0.f;
+		for (int32 Index = 0; Index < Hz; ++Index)
+		{
+			Value = FMath::Lerp(Value, 1.f, SkateSim::GetDecayAlpha(0.05f, 1.f / Hz));
+		}
+		float Reference = 0.f;
+		for (int32 Index = 0; Index < 60; ++Index)
+		{
+			Reference = FMath::Lerp(Reference, 1.f, 0.05f);
+		}
+		TestEqual(FString::Printf(TEXT("One second of decay at %d Hz matches 60 Hz"), Hz), Value, Reference, 1.e-3f);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateSimStepBoostTest, "SkateBGS.Simulation.StepBoost", SkateSimTestFlags)
+
+bool FSkateSimStepBoostTest::RunTest(const FString& Parameters)
+{
+	const FSkateSimParams Params;
+
+	FSkateSimState Boosting = SkateSim::MakeInitialState(Params);
+	SkateSim::StartBoost(Boosting, Params);
+	TestEqual(TEXT("Boosting raises the top speed"), Boosting.MaxWalkSpeed, Params.MaxSpeed);
+
+	FSkateSimState State = Boosting;
+	SkateSim::StepBoost(State, Params, 1000.f, 1.f / 60.f);
+	TestEqual(TEXT("One 60 Hz step drains stamina"), State.Stamina, 100.f - 62.5f / 60.f, KINDA_SMALL_NUMBER);
+
+	//Stamina is linear in time, so a second of boost drains the same at any rate or in one move
+	for (const int32 Hz : { 1, 30, 60, 120 })
+	{
+		State = RunBoost(Boosting, Params, 1000.f, 1.f, Hz);
+		TestEqual(FString::Printf(TEXT("One second of boost at %d Hz"), Hz), State.Stamina, 37.5f, 1.e-3f);
+		TestTrue(FString::Printf(TEXT("Still boosting after one second at %d Hz"), Hz), State.bIsSpeedingUp);
+	}
+
+	//Empty after 1.6 seconds, then regenerates for the rest
+	State = RunBoost(Boosting, Params, 1000.f, 2.f, 60);
+	TestFalse(TEXT("Running out of stamina ends the boost"), State.bIsSpeedingUp);
+	TestEqual(TEXT("Stamina regenerates once the boost ends"), State.Stamina, 31.25f * 0.4f, 0.6f);
+
+	//Top speed settles back after the boost at the same rate for any tick rate
+	FSkateSimState Coasting = SkateSim::MakeInitialState(Params);
+	Coasting.MaxWalkSpeed = Params.MaxSpeed;
+	State = Coasting;
+	SkateSim::StepBoost(State, Params, 1100.f, 1.f / 60.f);
+	TestEqual(TEXT("One 60 Hz step of top speed decay"), State.MaxWalkSpeed, 1200.f - 300.f * 0.002f, 1.e-3f);
+
+	const float Reference = RunBoost(Coasting, Params, 1100.f, 1.f, 60).MaxWalkSpeed;
+	for (const int32 Hz : { 30, 120, 144 })
+	{
+		TestEqual(FString::Printf(TEXT("One second of top speed decay at %d Hz matches 60 Hz"), Hz), RunBoost(Coasting, Params, 1100.f, 1.f, Hz).MaxWalkSpeed, Reference, 0.01f);
+	}
+
+	State = Coasting;
+	SkateSim::StepBoost(State, Params, 700.f, 1.f / 60.f);
+	TestEqual(TEXT("Slowing down well below regular speed snaps the top speed back"), State.MaxWalkSpeed, Params.RegularSpeed);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateSimStepTest, "SkateBGS.Simulation.Step", SkateSimTestFlags)
+
+bool FSkateSimStepTest::RunTest(const FString& Parameters)
+{
+	const FSkateSimParams Params;
+
+	FSkateSimInput Input;
+	Input.MoveAxis = FVector2D(0.f, 1.f);
+
+	//Step is a fixed 60 Hz step, the character runs it from an accumulator at any frame rate
+	FSkateSimState State = SkateSim::MakeInitialState(Params);
+	SkateSim::Step(State, Params, Input);
+	TestEqual(TEXT("One step eases the push by the friction"), State.ForwardScale, 0.01f, KINDA_SMALL_NUMBER);
+	SkateSim::Step(State, Params, Input);
+	TestEqual(TEXT("Two steps compound"), State.ForwardScale, 0.0199f, KINDA_SMALL_NUMBER);
+
+	State = SkateSim::MakeInitialState(Params);
+	Input.SlopeZ = 0.1f;
+	SkateSim::Step(State, Params, Input);
+	TestEqual(TEXT("Uphill pushes back"), State.ForwardScale, 0.01f * 0.7f, KINDA_SMALL_NUMBER);
+
+	State = SkateSim::MakeInitialState(Params);
+	Input.bIsFalling = true;
+	SkateSim::Step(State, Params, Input);
+	TestEqual(TEXT("The slope doesn't push in the air"), State.ForwardScale, 0.01f, KINDA_SMALL_NUMBER);
+
+	Input = FSkateSimInput();
+	Input.MoveAxis = FVector2D(1.f, 0.f);
+	TestEqual(TEXT("Standing still turns at the minimum rate"), SkateSim::Step(State, Params, Input), 0.25f, KINDA_SMALL_NUMBER);
+	Input.Speed = 600.f;
+	TestEqual(TEXT("Turning gets sharper with speed"), SkateSim::Step(State, Params, Input), 1.f, KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("A step turns as much as GetTurn"), SkateSim::GetTurn(State, Params, Input), 1.f, KINDA_SMALL_NUMBER);
+	return true;
+}
+
+#endif
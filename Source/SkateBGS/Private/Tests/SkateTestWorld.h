@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "UObject/UObjectGlobals.h"
+
+/** Empty game world for automation tests, begun play on construction and destroyed with the scope */
+class FSkateTestWorld
+{
+public:
+	FSkateTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SkateTestWorld"));
+		FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+		Context.SetCurrentWorld(World);
+
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+	}
+
+	~FSkateTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	UWorld* Get() const { return World; }
+
+	/** Ticks one frame and returns how long it took, in milliseconds */
+	double Tick(float DeltaTime)
+	{
+		const double Start = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, DeltaTime);
+		return (FPlatformTime::Seconds() - Start) * 1000.0;
+	}
+
+	/** Flat floor with its top at Z = 0, HalfExtent units out from the origin */
+	AStaticMeshActor* SpawnFloor(float HalfExtent = 50000.f)
+	{
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(0.f, 0.f, -50.f), FRotator::ZeroRotator);
+		if (Floor && Cube)
+		{
+			//The engine cube is 100 units across
+			Floor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+			Floor->SetActorScale3D(FVector(HalfExtent / 50.f, HalfExtent / 50.f, 1.f));
+		}
+		return Floor;
+	}
+
+	/** Actors in the world that aren't being destroyed */
+	int32 CountActors() const
+	{
+		int32 Count = 0;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			++Count;
+		}
+		return Count;
+	}
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif
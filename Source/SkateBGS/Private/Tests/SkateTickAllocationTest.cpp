@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#include "Tests/SkateTestWorld.h"
+#include "Characters/SkateCharacter.h"
+
+namespace
+{
+	constexpr int32 WarmUpFrames = 60;
+	constexpr int32 MeasuredFrames = 120;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSkateTickAllocationTest, "SkateBGS.Character.TickWithoutAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSkateTickAllocationTest::RunTest(const FString& Parameters)
+{
+	FSkateTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	TestWorld.SpawnFloor();
+
+	const FTransform SpawnTransform(FVector(0.f, 0.f, 100.f));
+	ASkateCharacter* Skater = World->SpawnActorDeferred<ASkateCharacter>(ASkateCharacter::StaticClass(), SpawnTransform);
+	Skater->bCreateHUD = false;
+	Skater->bIsBot = true;
+	Skater->FinishSpawning(SpawnTransform);
+	Skater->SpawnDefaultController();
+
+	//Pushing, turning and boosting, so every part of the tick runs. Warm up first so buffers reach their size
+	auto DriveFrame = [&TestWorld, Skater](int32 Frame)
+	{
+		Skater->ScriptedMove(FVector2D(FMath::Sin(Frame * 0.05f), 1.f));
+		if (Frame % 40 == 0)
+		{
+			Skater->ScriptedSpeed((Frame / 40) % 2 == 0);
+		}
+		TestWorld.Tick(1.f / 60.f);
+	};
+	for (int32 Frame = 0; Frame < WarmUpFrames; ++Frame)
+	{
+		DriveFrame(Frame);
+	}
+
+	//The allocator counters are process wide, other threads can add to a frame now and then but not to all of them
+	uint32 MinAllocations = MAX_uint32;
+	uint32 MaxAllocations = 0;
+	int32 FramesWithAllocations = 0;
+	for (int32 Frame = WarmUpFrames; Frame < WarmUpFrames + MeasuredFrames; ++Frame)
+	{
+		DriveFrame(Frame);
+		const uint32 Allocations = Skater->GetTickAllocations();
+		MinAllocations = FMath::Min(MinAllocations, Allocations);
+		MaxAllocations = FMath::Max(MaxAllocations, Allocations);
+		FramesWithAllocations += Allocations > 0 ? 1 : 0;
+	}
+
+	TestEqual(TEXT("The skater tick doesn't allocate"), MinAllocations, 0u);
+	AddInfo(FString::Printf(TEXT("%d of %d ticks counted allocations, at most %u"), FramesWithAllocations, MeasuredFrames, MaxAllocations));
+	return true;
+}
+
+#endif
@@ -4,49 +4,77 @@
 #include "UI/CharacterUI.h"
 #include "Components/ProgressBar.h"
 #include "Components/TextBlock.h"
+#include "Components/InvalidationBox.h"
+#include "SkateBGSStats.h"
+
+DECLARE_SKATE_CYCLE_STAT(TEXT("HUD Stamina"), STAT_SkateHUDStamina);
+DECLARE_SKATE_CYCLE_STAT(TEXT("HUD Ring Count"), STAT_SkateHUDRingCount);
+DECLARE_SKATE_CYCLE_STAT(TEXT("HUD Timer"), STAT_SkateHUDTimer);
+
+namespace
+{
+	//Runs last two minutes (1:59 on the skater), a longer configured run falls back to formatting
+	constexpr int32 CachedTimerMinutes = 2;
+
+	FText FormatTimer(int32 Minutes, int32 Seconds)
+	{
+		TStringBuilder<16> Text;
+		Text.Appendf(TEXT("%02d:%02d"), Minutes, Seconds);
+		return FText::AsCultureInvariant(FString(Text.ToView()));
+	}
+}
+
+void UCharacterUI::NativeOnInitialized()
+{
+	Super::NativeOnInitialized();
+
+	CountText.Reserve(100);
+	for (int32 Value = 0; Value < 100; ++Value)
+	{
+		CountText.Add(FText::AsCultureInvariant(FString::FromInt(Value)));
+	}
+
+	TimerText.Reserve(CachedTimerMinutes * 60);
+	for (int32 Value = 0; Value < CachedTimerMinutes * 60; ++Value)
+	{
+		TimerText.Add(FormatTimer(Value / 60, Value % 60));
+	}
+
+	if (HUDInvalidationBox)
+	{
+		HUDInvalidationBox->SetCanCache(true);
+	}
+}
 
 void UCharacterUI::SetStaminaPercent(float Percent)
 {
-	if (StaminaBar)
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateHUDStamina);
+	if (StaminaBar && Percent != DisplayedStaminaPercent)
 	{
+		DisplayedStaminaPercent = Percent;
 		StaminaBar->SetPercent(Percent);
 	}
 }
 
 void UCharacterUI::UpdateRingCount(int32 Rings)
 {
-	if (RingCount)
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateHUDRingCount);
+	if (RingCount && Rings != DisplayedRings)
 	{
-		RingCount->SetText(FText::FromString(FString::Printf(TEXT("%d"), Rings)));
+		DisplayedRings = Rings;
+		RingCount->SetText(CountText.IsValidIndex(Rings) ? CountText[Rings] : FText::AsCultureInvariant(FString::FromInt(Rings)));
 	}
 }
 
 void UCharacterUI::UpdateTimer(int32 Minutes, int32 Seconds)
 {
-	if (Timer)
+	SKATE_SCOPE_CYCLE_COUNTER(STAT_SkateHUDTimer);
+	if (Timer && (Minutes != DisplayedMinutes || Seconds != DisplayedSeconds))
 	{
-		FString MinuteString;
-		FString SecondString;
-
-		if (Minutes < 10)
-		{
-			MinuteString = FString::Printf(TEXT("0%d"), Minutes);
-		}
-		else
-		{
-			MinuteString = FString::Printf(TEXT("%d"), Minutes);
-		}
-
-		if (Seconds < 10)
-		{
-			SecondString = FString::Printf(TEXT("0%d"), Seconds);
-		}
-		else
-		{
-			SecondString = FString::Printf(TEXT("%d"), Seconds);
-		}
-
-		FString TimerText = FString(MinuteString + ":" + SecondString);
-		Timer->SetText(FText::FromString(TimerText));
+		DisplayedMinutes = Minutes;
+		DisplayedSeconds = Seconds;
+
+		const int32 TotalSeconds = Minutes * 60 + Seconds;
+		Timer->SetText(TimerText.IsValidIndex(TotalSeconds) && Seconds < 60 ? TimerText[TotalSeconds] : FormatTimer(Minutes, Seconds));
 	}
 }
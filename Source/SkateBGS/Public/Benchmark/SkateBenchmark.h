@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/**
+ * Benchmark counters of one stat declared with DECLARE_SKATE_CYCLE_STAT. Its SKATE_SCOPE_CYCLE_COUNTER
+ * scopes add their inclusive cycles here while a benchmark run is active, otherwise a scope costs one branch.
+ */
+struct SKATEBGS_API FSkateProbe
+{
+	explicit FSkateProbe(const TCHAR* InName);
+	~FSkateProbe();
+
+	const TCHAR* Name;
+	uint64 Cycles = 0;
+	uint32 Calls = 0;
+};
+
+struct SKATEBGS_API FSkateBenchmark
+{
+	static bool bActive;
+
+	/** Malloc and realloc calls the process made so far, the allocators only count them outside shipping */
+	static uint64 GetAllocCalls();
+
+	/** Every probe in the module, registered before any code runs */
+	static TArray<FSkateProbe*>& GetProbes();
+	static void ResetCounters();
+};
+
+struct FSkateProbeScope
+{
+	explicit FSkateProbeScope(FSkateProbe& InProbe)
+		: Probe(InProbe)
+		, StartCycles(FSkateBenchmark::bActive ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FSkateProbeScope()
+	{
+		if (StartCycles != 0)
+		{
+			Probe.Cycles += FPlatformTime::Cycles64() - StartCycles;
+			Probe.Calls += 1;
+		}
+	}
+
+private:
+	FSkateProbe& Probe;
+	uint64 StartCycles;
+};
+
+/** Sets Counter to the malloc and realloc calls made during the scope. Other threads share the allocator counters */
+struct FSkateAllocScope
+{
+	explicit FSkateAllocScope(uint32& InCounter)
+		: Counter(InCounter)
+		, StartCalls(FSkateBenchmark::GetAllocCalls())
+	{
+	}
+
+	~FSkateAllocScope()
+	{
+		Counter = (uint32)(FSkateBenchmark::GetAllocCalls() - StartCalls);
+	}
+
+private:
+	uint32& Counter;
+	uint64 StartCalls;
+};
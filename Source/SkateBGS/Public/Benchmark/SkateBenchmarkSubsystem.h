@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SkateBenchmarkSubsystem.generated.h"
+
+class ASkateCharacter;
+
+/** One frame of a benchmark run, the per probe numbers are kept next to it in flat arrays */
+struct FSkateBenchmarkRow
+{
+	double FrameMs = 0.0;
+	int32 TraceQueries = 0;
+	uint32 TickAllocs = 0;
+	uint64 Allocs = 0;
+};
+
+/**
+ * Spawns N skaters and a generated ring course, drives them with scripted input for a fixed
+ * number of frames and writes ms/frame, allocation counts and the inclusive time and calls of every
+ * SKATE_SCOPE_CYCLE_COUNTER stat to Saved/Profiling as CSV.
+ * Everything it spawns is destroyed when the run finishes.
+ *
+ * Console: Skate.Benchmark [Skaters] [Frames] [Rings]
+ * Headless: SkateBGS /Game/Maps/SkateMap -game -nullrhi -benchmark -fps=60 -SkateBenchmark
+ *           [-SkateBenchSkaters=N -SkateBenchFrames=N -SkateBenchRings=N], exits when done.
+ * Automation: the SkateBGS.Benchmark test runs a short benchmark in an empty world.
+ */
+UCLASS(config = Game)
+class SKATEBGS_API USkateBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return bRunning; }
+
+	void StartBenchmark(int32 NumSkaters, int32 NumFrames, int32 NumRings);
+
+	bool IsRunning() const { return bRunning; }
+
+	/** CSV written by the last finished run, empty if it couldn't be written */
+	const FString& GetLastCsvPath() const { return LastCsvPath; }
+
+	/** Skater Blueprint to spawn, falls back to the native class */
+	UPROPERTY(config)
+	TSoftClassPtr<ASkateCharacter> SkaterClass;
+
+private:
+	UPROPERTY(Transient)
+	TArray<ASkateCharacter*> Skaters;
+
+	UPROPERTY(Transient)
+	class ARingManager* RingManager;
+
+	bool bRunning = false;
+	bool bExitWhenDone = false;
+	int32 Frame = 0;
+	int32 FramesToRun = 0;
+	double LastFrameTime = 0.0;
+	uint64 LastAllocCalls = 0;
+	TArray<FSkateBenchmarkRow> Rows;
+	TArray<uint64> ProbeCycles;
+	TArray<uint32> ProbeCalls;
+	FString LastCsvPath;
+
+	void SpawnSkaters(int32 NumSkaters);
+	void SpawnRingCourse(int32 NumRings);
+	void DriveSkaters();
+	void RecordFrame(double FrameSeconds);
+	void FinishBenchmark();
+	FString FormatCsv() const;
+	void DestroySpawnedActors();
+};
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "Characters/SkateSimulation.h"
+#include "Characters/SkateTraceQueries.h"
+#include "SkateBotCrowd.generated.h"
+
+class ASkateCharacter;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Hundreds of wandering bot skaters for load testing. Bots are plain arrays stepped with the same
+ * SkateSim rules as the player, their ground height comes from a fixed budget of async probes per
+ * frame and they render as one instanced mesh. Bots close to the player are swapped for a pooled
+ * full ASkateCharacter and handed back to the arrays when they drift away again.
+ */
+UCLASS()
+class SKATEBGS_API ASkateBotCrowd : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASkateBotCrowd();
+
+	virtual void Tick(float DeltaTime) override;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UInstancedStaticMeshComponent* BotInstances;
+
+	UPROPERTY(EditAnywhere, Category = "Crowd", meta = (ClampMin = "0"))
+	int32 NumBots = 300;
+
+	/** Bots spawn inside this radius around the crowd actor and steer back when they leave it */
+	UPROPERTY(EditAnywhere, Category = "Crowd")
+	float Radius = 5000.f;
+
+	UPROPERTY(EditAnywhere, Category = "Crowd")
+	int32 RandomSeed = 1;
+
+	/** Ground probes issued per frame, each bot's ground is refreshed every NumBots / ProbesPerFrame frames */
+	UPROPERTY(EditAnywhere, Category = "Crowd", meta = (ClampMin = "1"))
+	int32 ProbesPerFrame = 64;
+
+	/** Height of the actor origin above the ground, matches the skater capsule */
+	UPROPERTY(EditAnywhere, Category = "Crowd")
+	float GroundOffset = 90.f;
+
+	UPROPERTY(EditAnywhere, Category = "Crowd")
+	float MaxAcceleration = 2048.f;
+
+	/** Full skater used near the player, also the source of the movement tuning */
+	UPROPERTY(EditAnywhere, Category = "Crowd|Promotion")
+	TSubclassOf<ASkateCharacter> SkaterClass;
+
+	UPROPERTY(EditAnywhere, Category = "Crowd|Promotion")
+	float PromoteDistance = 2500.f;
+
+	/** Larger than PromoteDistance so bots on the edge don't swap back and forth */
+	UPROPERTY(EditAnywhere, Category = "Crowd|Promotion")
+	float DemoteDistance = 3000.f;
+
+	UPROPERTY(EditAnywhere, Category = "Crowd|Promotion")
+	int32 MaxPromoted = 8;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	//One entry per bot in each array
+	TArray<FVector> Locations;
+	TArray<float> Yaws;
+	TArray<float> Speeds;
+	TArray<float> GroundZ;
+	TArray<float> SlopeZ;
+	TArray<FVector2D> MoveAxes;
+	TArray<float> NextWanderTimes;
+	TArray<FSkateSimState> States;
+
+	//Instance transforms, refilled every frame without reallocating
+	TArray<FTransform> InstanceTransforms;
+
+	/** Index into PromotedActors, or INDEX_NONE while the bot is simulated here */
+	TArray<int32> Promoted;
+
+	UPROPERTY(Transient)
+	TArray<ASkateCharacter*> PromotedActors;
+
+	TArray<int32> PromotedBots;
+
+	//Demoted skaters, hidden and waiting for the next promotion
+	UPROPERTY(Transient)
+	TArray<ASkateCharacter*> IdleActors;
+
+	FSkateSimParams SimParams;
+	float SimAccumulator = 0.f;
+	FRandomStream Random;
+
+	FSkateTraceQueries TraceQueries;
+	FTraceDelegate ProbeDelegate;
+	int32 NextProbe = 0;
+
+	void SpawnBots();
+	void Wander(int32 Bot, float Time);
+	void StepBots(float DeltaTime);
+	void RequestProbes();
+	void OnProbeDone(const FTraceHandle& Handle, FTraceDatum& Datum);
+	void UpdatePromotion();
+	void Promote(int32 Bot);
+	void Demote(int32 Slot);
+	void UpdateInstances();
+};
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SkateBoardPhysics.generated.h"
+
+class FSkateBoardCallback;
+class UPrimitiveComponent;
+
+/** Board tuning, accelerations are per unit mass so the body's mass doesn't change the feel */
+USTRUCT(BlueprintType)
+struct FSkateBoardTuning
+{
+	GENERATED_BODY()
+
+	/** Suspension mounts relative to the body: front left, front right, back left, back right */
+	UPROPERTY(EditAnywhere, Category = "Suspension")
+	FVector WheelOffsets[4] = { FVector(35.f, -12.f, 0.f), FVector(35.f, 12.f, 0.f), FVector(-35.f, -12.f, 0.f), FVector(-35.f, 12.f, 0.f) };
+
+	UPROPERTY(EditAnywhere, Category = "Suspension")
+	float SuspensionLength = 30.f;
+
+	UPROPERTY(EditAnywhere, Category = "Suspension")
+	float SpringStiffness = 400.f;
+
+	UPROPERTY(EditAnywhere, Category = "Suspension")
+	float SpringDamping = 30.f;
+
+	/** How fast sideways slip at the wheels is cancelled, per second */
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float LateralGrip = 8.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float RollingDrag = 0.1f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float PushAcceleration = 600.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float BoostAcceleration = 1200.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float MaxPushSpeed = 1200.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float MaxBoostSpeed = 2000.f;
+
+	/** Yaw rate at full stick, degrees per second */
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float TurnRate = 120.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float SteerResponse = 10.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float JumpSpeed = 500.f;
+
+	UPROPERTY(EditAnywhere, Category = "Drive")
+	float AirAngularDamping = 2.f;
+};
+
+/**
+ * Drives a simulated body as a four wheel raycast suspension board from a Chaos sim callback, so
+ * it runs every physics step (on the physics thread with async physics) instead of once a frame.
+ *
+ * Scene queries stay on the game thread: the owner finds the ground under each wheel once a frame
+ * and passes it in as a contact plane, the physics steps intersect the wheel rays with those planes
+ * at their own rate. Back on the game thread the body's transform is the interpolated one, the
+ * callback only reports which wheels touched the ground.
+ */
+UCLASS(ClassGroup = (Skate))
+class SKATEBGS_API USkateBoardPhysics : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USkateBoardPhysics();
+
+	static constexpr int32 NumWheels = 4;
+
+	void StartSimulating(UPrimitiveComponent* InBody);
+	void StopSimulating();
+	bool IsSimulating() const { return Callback != nullptr; }
+
+	void SetMoveInput(const FVector2D& InMoveAxis, bool bInBoost);
+	void RequestJump() { ++JumpCount; }
+
+	void SetWheelContact(int32 Wheel, const FVector& Location, const FVector& Normal);
+	void ClearWheelContact(int32 Wheel);
+
+	/** Suspension mount from the body's interpolated transform */
+	FVector GetWheelLocation(int32 Wheel) const;
+
+	/** Sends this frame's input and contacts and reads back the results of the steps that finished */
+	void ExchangeWithPhysics();
+
+	bool IsGrounded() const { return GroundedMask != 0; }
+	FVector GetFloorNormal() const { return FloorNormal; }
+
+	UPROPERTY(EditAnywhere, Category = "Board")
+	FSkateBoardTuning Tuning;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	FSkateBoardCallback* Callback = nullptr;
+
+	TWeakObjectPtr<UPrimitiveComponent> Body;
+
+	FVector2D MoveAxis = FVector2D::ZeroVector;
+	bool bBoost = false;
+	int32 JumpCount = 0;
+
+	FVector ContactLocations[NumWheels];
+	FVector ContactNormals[NumWheels];
+	uint8 ContactMask = 0;
+
+	uint8 GroundedMask = 0;
+	FVector FloorNormal = FVector::UpVector;
+};
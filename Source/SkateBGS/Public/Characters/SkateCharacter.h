@@ -4,6 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
+#include "Characters/SkateTraceQueries.h"
+#include "Characters/SkateSimulation.h"
+#include "Ghost/GhostRecording.h"
 #include "SkateCharacter.generated.h"
 
 class UInputMappingContext;
@@ -11,6 +15,11 @@ class UInputAction;
 struct FInputActionValue;
 class USpringArmComponent;
 class UCameraComponent;
+class USkateInputRecorder;
+class USkateMovementComponent;
+class USkateBoardPhysics;
+class USphereComponent;
+class ASkateGroundField;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnRingCollected);
 
@@ -19,14 +28,21 @@ class SKATEBGS_API ASkateCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	//Replays call the input handlers directly and hash private state
+	friend class USkateInputRecorder;
+
 public:
 	// Sets default values for this character's properties
-	ASkateCharacter();
+	ASkateCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void NotifyControllerChanged() override;
+
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
 
@@ -35,7 +51,6 @@ protected:
 
 	void MoveTrigger(const FInputActionValue& Value);
 
-	void MovePhysics(const FInputActionValue& Value);
 
 	void ReleaseTrigger();
 
@@ -69,8 +84,13 @@ protected:
 	UPROPERTY(EditAnywhere, category = "Movement")
 	float MaxStamina = 100.f;
 
+	/** Stamina lost per second while boosting */
+	UPROPERTY(EditAnywhere, category = "Movement")
+	float StaminaDrainPerSecond = 62.5f;
+
+	/** Stamina recovered per second while not boosting */
 	UPROPERTY(EditAnywhere, category = "Movement")
-	float StaminaDrainRate = 1.f;
+	float StaminaRegenPerSecond = 31.25f;
 
 	UPROPERTY(EditAnywhere, category = "Movement")
 	float TurnRate = 1.5f;
@@ -81,6 +101,18 @@ protected:
 	UPROPERTY(EditAnywhere, category = "Movement")
 	float DecelerationRate = 5.f;
 
+	/**
+	 * Ride the Sphere body as a suspension board on the physics steps instead of the movement component.
+	 * Standalone only, it skips the predicted boost and HandleImpact crashes. The board runs on every physics
+	 * step, enable Tick Physics Async in the project's physics settings to have those at a fixed rate.
+	 */
+	UPROPERTY(EditAnywhere, category = "Movement")
+	bool bUsePhysicsMovement = false;
+
+	/** Submit the four skate floor probes as one async batch and use the results on the next frame */
+	UPROPERTY(EditAnywhere, category = "Movement")
+	bool bUseAsyncFloorProbes = true;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, category = "Movement")
 	float ForwardScaleValue;
 
@@ -104,6 +136,8 @@ protected:
 	UPROPERTY(EditAnywhere, category = "Time")
 	int32 Seconds = 59.f;
 
+	virtual void Landed(const FHitResult& Hit) override;
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void CallResetMenu();
 
@@ -113,13 +147,35 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	bool bHasWon = false;
 
+	/** Hitting a wall faster than this along its normal ends the run */
+	UPROPERTY(EditAnywhere, category = "Movement")
+	float CrashSpeed = 750.f;
+
+	/** Tick interval for skaters this machine doesn't control: all of them on a server, far ones on clients. 0 ticks every frame */
+	UPROPERTY(EditAnywhere, category = "Performance", meta = (ClampMin = "0", ClampMax = "0.1"))
+	float RemoteTickInterval = 1.f / 30.f;
+
+	/** Remote skaters closer than this to the camera tick every frame so their skate stays smooth */
+	UPROPERTY(EditAnywhere, category = "Performance")
+	float RemoteFullTickDistance = 3000.f;
+
 	UPROPERTY(EditAnywhere)
 	USoundBase* DeathSound;
 
+	/** Spawned to replay the best run on this map, if one was saved */
+	UPROPERTY(EditAnywhere, category = "Ghost")
+	TSubclassOf<class ASkateGhost> GhostClass;
+
+	/** Record the player's run and keep it as the ghost when it beats the best time */
+	UPROPERTY(EditAnywhere, category = "Ghost")
+	bool bRecordGhost = true;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual FVector GetVelocity() const override;
+
 	//Code From the default Unreal Character
 	// 
 	// Called to bind functionality to input
@@ -157,43 +213,125 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	UStaticMeshComponent* SkateMesh;
 
+	/** Board body of the physics movement mode, unused while bUsePhysicsMovement is off */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	USphereComponent* Sphere;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	USkateBoardPhysics* BoardPhysics;
+
+	/** Records or replays input when launched with -SkateRecordInput= or -SkateReplayInput= */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-	UStaticMeshComponent* Sphere;
+	USkateInputRecorder* InputRecorder;
+
+	/** The HUD is only created once a local player possesses the skater, this turns it off even then */
+	UPROPERTY(EditAnywhere, Category = "UI")
+	bool bCreateHUD = true;
+
+	/** Crowd bots skate like the player but don't own the run: no countdown, reset menu or victory */
+	UPROPERTY(EditAnywhere, Category = "Bots")
+	bool bIsBot = false;
 
 	FOnRingCollected RingCollected;
 
 	void CollectRing();
 
+	void ResetRingCount();
+
+	/** Feeds input through the same handlers as the Enhanced Input bindings, for benchmarks and replays */
+	void ScriptedMove(const FVector2D& MoveAxis);
+	void ScriptedSpeed(bool bPressed);
+
+	/** Stands a dead skater back up on its board, for skaters that are reused instead of respawned */
+	void Revive();
+
+	const FSkateTraceQueries& GetTraceQueries() const { return TraceQueries; }
+
+	/** Malloc and realloc calls made during the last Tick, always 0 in shipping */
+	uint32 GetTickAllocations() const { return TickAllocations; }
+
+	/** Wall hits from the movement component's own sweeps, with the velocity going into the hit */
+	void OnSkateImpact(const FHitResult& Hit, const FVector& ImpactVelocity);
+
+	USkateMovementComponent* GetSkateMovement() const;
+
+	/** False on dedicated servers, which skip the HUD, camera and skate mesh work */
+	bool HasPresentation() const;
+
+	/** Tuning for the skate simulation, shared with the movement component's predicted boost */
+	FSkateSimParams GetSimParams() const;
+
 private:
 	bool bIsHoldingMoveAxis = false;
 	bool bIsHoldingSpeed = false;
 	bool bCanFlipSkate = false;
 	float RightScaleValue;
-	float GetDecelerationScale(float CurrentSpeed);
+
+	//Skate feel runs in fixed steps, the character only feeds input and applies the results
+	FSkateSimState SimState;
+	float SimAccumulator = 0.f;
+	FSkateSimInput MakeSimInput() const;
+	void StepSimulation(float DeltaTime);
+	void SyncFromSimState();
 	FVector FloorNormal = FVector(0.f, 0.f, 1.f);
 
-	void AlignSkate();
+	FSkateTraceQueries TraceQueries;
+	uint32 TickAllocations = 0;
+
+	void AlignSkate(float DeltaTime);
 	FVector TraceFloor(const FVector Origin);
+
+	//Baked static ground, probes only trace where it has no answer
+	UPROPERTY()
+	TWeakObjectPtr<ASkateGroundField> GroundField;
+	bool SampleGroundField(const FVector* Origins, FVector* OutLocations) const;
+
+	//Forward, Backward, LeftWheel, RightWheel
+	static constexpr int32 NumFloorProbes = 4;
+	FTraceDelegate FloorProbeDelegate;
+	FVector FloorProbeResults[NumFloorProbes];
+	uint32 FloorProbeBatch = 0;
+	uint8 FloorProbeMask = 0;
+	bool bFloorProbesPending = false;
+	void RequestFloorProbes(const FVector* Origins);
+	bool ConsumeFloorProbes(FVector* OutLocations);
+	void OnFloorProbeDone(const FTraceHandle& Handle, FTraceDatum& Datum);
 	void SpeedTrigger();
 	void FlipSkate();
 
-	FVector GetSimulatedVelocity();
-	FVector GetFloorNormal(const FVector Origin);
-	void SetPhysicsMovement();
+	FVector GetSimulatedVelocity() const;
+	bool TraceWheelContact(const FVector Origin, FVector& OutLocation, FVector& OutNormal);
+	void SetPhysicsMovement(float DeltaTime);
 
-	void UpdateCamera(const float& Speed);
+	/** Turns bUsePhysicsMovement off outside standalone games, called once from BeginPlay */
+	void ValidatePhysicsMovement();
+
+	//Sphere's place relative to the actor, kept when it starts simulating on its own
+	FVector PhysicsBodyOffset = FVector::ZeroVector;
+
+	void UpdateCamera(const float& Speed, float DeltaTime);
 	float CameraFOV = 90.f;
 	float ArmLength = 300.f;
 
-	FTimerHandle StaminaDrainTimer;
-	FTimerHandle StaminaRegenTimer;
+	void UpdateTickInterval();
+
 	FTimerHandle TimerHandle;
-	void DrainStamina();
-	void RegenStamina();
+	int32 DisplayedStaminaPercent = -1;
+
+	FGhostWriter GhostWriter;
+	float RunStartTime = 0.f;
+	bool bGhostRunStarted = false;
+
+	//First frame the local player can skate, reported to USkateLoadingSubsystem
+	bool bReportedControllable = false;
+	FString GetGhostPath() const;
+	void StartGhostRun();
+	void RecordGhostFrame();
 
 	int32 RingCounter = 0;
 	void CountDown();
 	void StopAllActions();
 	void TraceCollision();
+	bool bIsDead = false;
 	void Die();
 };
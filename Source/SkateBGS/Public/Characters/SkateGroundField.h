@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Serialization/BulkData.h"
+#include "SkateGroundField.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Height and normal of the static skateable ground inside Bounds, baked in the editor so AlignSkate
+ * can read the floor under the board instead of tracing for it. Samples are 4 bytes (16 bit height,
+ * octahedral normal) in square tiles with a one sample apron so every bilinear lookup stays in one
+ * tile; tiles with no ground aren't stored. The samples are cooked as bulk data outside the export
+ * so they can be memory mapped.
+ *
+ * Place one per map, size the box over the skate area and press Bake. Cells under movable objects
+ * at bake time are stored as "trace here", lookups there and over ledges fall back to traces.
+ */
+UCLASS(hidecategories = (Collision, Physics, Rendering, Input))
+class SKATEBGS_API ASkateGroundField : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASkateGroundField();
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	/** Floor under Location between Above and Below it, false when a trace has to answer instead */
+	bool SampleFloor(const FVector& Location, float Above, float Below, FVector& OutLocation, FVector* OutNormal = nullptr) const;
+
+#if WITH_EDITOR
+	/** Samples the ground in Bounds from the editor world */
+	UFUNCTION(CallInEditor, Category = "Ground Field")
+	void Bake();
+#endif
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UBoxComponent* Bounds;
+
+	UPROPERTY(EditAnywhere, Category = "Ground Field", meta = (ClampMin = "5"))
+	float CellSize = 50.f;
+
+	/** Height difference between neighbouring samples treated as a ledge, lookups across it trace instead */
+	UPROPERTY(EditAnywhere, Category = "Ground Field")
+	float MaxStepHeight = 20.f;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	static constexpr int32 TileSize = 32;
+	static constexpr int32 TileStride = TileSize + 1;
+	static constexpr int32 SamplesPerTile = TileStride * TileStride;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ground Field")
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ground Field")
+	int32 NumTilesX = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ground Field")
+	int32 NumTilesY = 0;
+
+	UPROPERTY()
+	float MinZ = 0.f;
+
+	UPROPERTY()
+	float HeightStep = 1.f;
+
+	/** Index of each tile's samples in SampleData, INDEX_NONE when the tile has no ground */
+	UPROPERTY()
+	TArray<int32> TileOffsets;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ground Field")
+	int32 NumStoredTiles = 0;
+
+	FByteBulkData SampleData;
+
+	//Locked for the whole play session
+	const uint8* Samples = nullptr;
+};
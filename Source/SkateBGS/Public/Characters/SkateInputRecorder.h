@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SkateInputRecorder.generated.h"
+
+class ASkateCharacter;
+class UEnhancedInputComponent;
+class UInputAction;
+struct FInputActionValue;
+
+/**
+ * Records the skater's Enhanced Input stream to a compact binary file and plays it back through
+ * the same ASkateCharacter handlers. Both run the engine at the same fixed timestep, so an event
+ * recorded on a frame replays after the same simulated time; the previous timestep is restored in EndPlay.
+ *
+ * -SkateRecordInput=<File> records, -SkateReplayInput=<File> replays. Relative paths go under
+ * Saved/InputRecordings. A replay hashes location, velocity, stamina and ring count every frame
+ * into <File>.hash; when that file already exists the replay compares against it instead and logs
+ * the first frame that diverges.
+ * Only the locally controlled player's skater arms it, see Arm.
+ */
+UCLASS(ClassGroup = (Skate))
+class SKATEBGS_API USkateInputRecorder : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USkateInputRecorder();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Adds recording bindings next to the character's own, called from SetupPlayerInputComponent */
+	void BindInput(UEnhancedInputComponent* InputComponent, const UInputAction* MoveAction, const UInputAction* LookAction,
+		const UInputAction* JumpAction, const UInputAction* SpeedAction);
+
+	/** Starts recording or replaying if the command line asks for it. Called when a local player possesses the skater, does nothing once armed */
+	void Arm();
+
+	bool IsReplaying() const { return Mode == EMode::Replay; }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	enum class EMode : uint8
+	{
+		None,
+		Record,
+		Replay
+	};
+
+	enum class EEvent : uint8
+	{
+		Move,
+		MoveReleased,
+		Look,
+		Jump,
+		JumpReleased,
+		Speed,
+		SpeedReleased,
+		End
+	};
+
+	struct FEvent
+	{
+		uint32 Frame = 0;
+		EEvent Type = EEvent::End;
+		FVector2f Value = FVector2f::ZeroVector;
+	};
+
+	EMode Mode = EMode::None;
+	FString FilePath;
+	uint64 StartFrameCounter = 0;
+	float FixedDeltaTime = 1.f / 60.f;
+
+	//Engine timestep before this component forced its own
+	bool bPreviousUseFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+	bool bForcedFixedTimeStep = false;
+	void ForceFixedTimeStep();
+	void RestoreTimeStep();
+
+	TArray<FEvent> Events;
+	int32 NextEvent = 0;
+
+	//Move fires every frame while held, only changes are stored and replay repeats the last value
+	bool bMoveHeld = false;
+	FVector2f LastMove = FVector2f::ZeroVector;
+
+	TArray<uint32> StateHashes;
+	TArray<uint8> ReferenceHashes;
+	bool bReportedDivergence = false;
+
+	ASkateCharacter* GetSkater() const;
+	uint32 GetFrame() const;
+	uint32 HashState() const;
+
+	void RecordEvent(EEvent Type, const FVector2f& Value = FVector2f::ZeroVector);
+	void OnMove(const FInputActionValue& Value);
+	void OnMoveReleased();
+	void OnLook(const FInputActionValue& Value);
+	void OnJump();
+	void OnJumpReleased();
+	void OnSpeed();
+	void OnSpeedReleased();
+
+	void DispatchEvent(const FEvent& Event);
+	void CheckStateHash(uint32 Frame);
+
+	bool SaveRecording() const;
+	bool LoadRecording();
+	void SaveHashes() const;
+};
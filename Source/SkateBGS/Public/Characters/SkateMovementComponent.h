@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Characters/SkateSimulation.h"
+#include "SkateMovementComponent.generated.h"
+
+/** Client move data with the stamina the client ended the move at, so the server can correct it */
+struct FSkateNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	float Stamina = 0.f;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+struct FSkateNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FSkateNetworkMoveDataContainer();
+
+	FSkateNetworkMoveData SkateMoveData[3];
+};
+
+/** Corrections carry the server's boost state, replayed moves step it forward from there */
+struct FSkateMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	typedef FCharacterMoveResponseDataContainer Super;
+
+	FSkateSimState BoostState;
+	bool bBoostExhausted = false;
+
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+};
+
+UENUM(BlueprintType)
+enum ESkateMovementMode
+{
+	CMOVE_Skate = 0 UMETA(DisplayName = "Skate")
+};
+
+/**
+ * Character movement with the skate boost folded into predicted moves. The boost button travels as
+ * a compressed flag, stamina and top speed are stepped inside each move on both the owning client
+ * and the server. Client moves also carry their end stamina; when it drifts the server corrects,
+ * the correction carries the boost state and replayed moves step it forward from there.
+ * Grounded movement runs in the custom PhysSkate mode.
+ */
+UCLASS(ClassGroup = (Skate))
+class SKATEBGS_API USkateMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Skate;
+	friend struct FSkateMoveResponseDataContainer;
+
+public:
+	USkateMovementComponent();
+
+	/** Holds the boost while true, the skater drops it when stamina runs out until this is released */
+	void SetWantsToBoost(bool bWants);
+
+	bool IsBoosting() const { return BoostState.bIsSpeedingUp; }
+	float GetStamina() const { return BoostState.Stamina; }
+
+	virtual bool IsMovingOnGround() const override;
+	virtual float GetMaxSpeed() const override;
+	virtual float GetMaxBrakingDeceleration() const override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	/** Run grounded movement in PhysSkate instead of PhysWalking */
+	UPROPERTY(EditAnywhere, Category = "Character Movement: Skate")
+	bool bUseSkateMovementMode = true;
+
+	/** Stamina difference between the client's move and the server's that forces a correction */
+	UPROPERTY(EditAnywhere, Category = "Character Movement: Skate")
+	float StaminaErrorTolerance = 1.f;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void PhysCustom(float DeltaTime, int32 Iterations) override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc,
+		UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+	virtual void HandleImpact(const FHitResult& Hit, float TimeSlice = 0.f, const FVector& MoveDelta = FVector::ZeroVector) override;
+
+	void PhysSkate(float DeltaTime, int32 Iterations);
+
+private:
+	FSkateSimParams GetSimParams() const;
+
+	bool bWantsToBoost = false;
+
+	/** Set when stamina ends a boost, keeps a held button from restarting it */
+	bool bBoostExhausted = false;
+
+	FSkateSimState BoostState;
+
+	FSkateNetworkMoveDataContainer SkateMoveDataContainer;
+	FSkateMoveResponseDataContainer SkateMoveResponseDataContainer;
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Skate movement rules with no engine dependencies: forward push with friction, boost and stamina,
+ * top speed decay and turning. ASkateCharacter steps the push and turning, USkateMovementComponent
+ * steps boost and stamina inside predicted moves; both can run headless or in benchmarks.
+ */
+struct FSkateSimParams
+{
+	float RegularSpeed = 900.f;
+	float MaxSpeed = 1200.f;
+	float MaxStamina = 100.f;
+	float StaminaDrainPerSecond = 62.5f;
+	float StaminaRegenPerSecond = 31.25f;
+	float TurnRate = 1.5f;
+	float Friction = 0.01f;
+	float DecelerationRate = 5.f;
+
+	/** Length of one Step, the tuning values above were authored at 60 Hz */
+	float FixedTimeStep = 1.f / 60.f;
+};
+
+struct FSkateSimInput
+{
+	/** Raw move input, X = right, Y = forward */
+	FVector2D MoveAxis = FVector2D::ZeroVector;
+
+	/** Current speed of the skater */
+	float Speed = 0.f;
+
+	/** Z of the board's forward vector, pushes back uphill and forward downhill */
+	float SlopeZ = 0.f;
+
+	bool bIsFalling = false;
+};
+
+struct FSkateSimState
+{
+	/** Scale of the forward movement input */
+	float ForwardScale = 0.f;
+	float MaxWalkSpeed = 900.f;
+	float Stamina = 100.f;
+	bool bIsSpeedingUp = false;
+};
+
+namespace SkateSim
+{
+	SKATEBGS_API FSkateSimState MakeInitialState(const FSkateSimParams& Params);
+
+	SKATEBGS_API float GetDecelerationScale(const FSkateSimParams& Params, float Speed, float ForwardAxis);
+
+	/** Lerp alpha for DeltaTime that decays as fast as StepAlpha applied every StepTime, so smoothing doesn't depend on the tick rate */
+	SKATEBGS_API float GetDecayAlpha(float StepAlpha, float DeltaTime, float StepTime = 1.f / 60.f);
+
+	/** Whether the skater is grounded and pushing forward, the only time a boost may start */
+	SKATEBGS_API bool CanStartBoost(const FSkateSimInput& Input);
+
+	SKATEBGS_API void StartBoost(FSkateSimState& State, const FSkateSimParams& Params);
+
+	SKATEBGS_API void StopBoost(FSkateSimState& State);
+
+	/** Eases off the push when a boost starts from below regular speed */
+	SKATEBGS_API void ApplyBoostPush(FSkateSimState& State, const FSkateSimParams& Params, float Speed);
+
+	/** Advances stamina and top speed by DeltaTime, which can be any length so predicted moves can be replayed or combined */
+	SKATEBGS_API void StepBoost(FSkateSimState& State, const FSkateSimParams& Params, float Speed, float DeltaTime);
+
+	/** Yaw to add over one Params.FixedTimeStep for this input, in degrees */
+	SKATEBGS_API float GetTurn(const FSkateSimState& State, const FSkateSimParams& Params, const FSkateSimInput& Input);
+
+	/** Advances the forward push by Params.FixedTimeStep and returns the yaw to add this step, in degrees */
+	SKATEBGS_API float Step(FSkateSimState& State, const FSkateSimParams& Params, const FSkateSimInput& Input);
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+
+class UWorld;
+
+/**
+ * Collision queries for a single skater. The query params and ignore list are built once in Init
+ * and reused for every trace, so the tick path doesn't allocate or rebuild params.
+ */
+class SKATEBGS_API FSkateTraceQueries
+{
+public:
+	FSkateTraceQueries();
+
+	void Init(const AActor* InOwner, ETraceTypeQuery TraceType);
+
+	bool LineTrace(const UWorld* World, const FVector& Start, const FVector& End, FHitResult& OutHit);
+
+	bool BoxSweep(const UWorld* World, const FVector& Start, const FVector& End, const FQuat& Rotation, const FVector& HalfExtent, FHitResult& OutHit);
+
+	FTraceHandle AsyncLineTrace(UWorld* World, const FVector& Start, const FVector& End, const FTraceDelegate* Delegate, uint32 UserData);
+
+	const FCollisionQueryParams& GetQueryParams() const { return QueryParams; }
+
+	ECollisionChannel GetChannel() const { return Channel; }
+
+	/** Resets the per-frame counters, call once at the start of the owner's tick */
+	void BeginFrame();
+
+	/** Queries issued since BeginFrame */
+	int32 GetFrameQueries() const { return FrameQueries; }
+
+private:
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+	ECollisionChannel Channel = ECC_Visibility;
+
+	int32 FrameQueries = 0;
+
+	void CountQuery();
+};
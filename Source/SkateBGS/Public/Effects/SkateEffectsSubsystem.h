@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SkateEffectsSubsystem.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraComponent;
+class USoundBase;
+class UAudioComponent;
+
+USTRUCT()
+struct FSkateNiagaraPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UNiagaraComponent*> Components;
+
+	int32 Next = 0;
+};
+
+USTRUCT()
+struct FSkateSoundPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UAudioComponent*> Components;
+
+	int32 Next = 0;
+};
+
+/**
+ * One-shot VFX and sounds played from a few components per asset created up front, so gameplay
+ * events such as ring pickups and deaths don't create components. When every component of an asset
+ * is busy the oldest one is restarted.
+ */
+UCLASS()
+class SKATEBGS_API USkateEffectsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/** Creates components for the asset until it has at least Count, call from BeginPlay */
+	void Prewarm(UNiagaraSystem* System, int32 Count = 4);
+	void Prewarm(USoundBase* Sound, int32 Count = 4);
+
+	void PlayEffect(UNiagaraSystem* System, const FVector& Location);
+	void PlaySound(USoundBase* Sound, const FVector& Location);
+
+private:
+	UPROPERTY(Transient)
+	TMap<UNiagaraSystem*, FSkateNiagaraPool> EffectPools;
+
+	UPROPERTY(Transient)
+	TMap<USoundBase*, FSkateSoundPool> SoundPools;
+};
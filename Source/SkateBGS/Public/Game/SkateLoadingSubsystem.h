@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "SkateLoadingSubsystem.generated.h"
+
+struct FStreamableHandle;
+class UWorld;
+
+/**
+ * Starts loading the gameplay assets through the Asset Manager as soon as the game boots, so they
+ * are in memory while the menu is up and the jump to SkateMap only loads the level itself. The
+ * handle is kept for the whole session so going back to the menu doesn't unload them. Dedicated
+ * servers skip the preload.
+ *
+ * Also logs the time to the first controllable frame after launch and after each map load.
+ */
+UCLASS(config = Game)
+class SKATEBGS_API USkateLoadingSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintPure, Category = "Loading")
+	bool IsPreloadComplete() const;
+
+	/** 0 to 1, for a progress bar on the menu */
+	UFUNCTION(BlueprintPure, Category = "Loading")
+	float GetPreloadProgress() const;
+
+	/** Called by the player's skater on its first tick, logs the first controllable frame once per map */
+	void NotifyPlayerControllable();
+
+	/** Character Blueprint, HUD widget, ring VFX and sounds, jump montage... */
+	UPROPERTY(config)
+	TArray<FSoftObjectPath> PreloadAssets;
+
+private:
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+	double PreloadStartTime = 0.0;
+	double MapLoadStartTime = 0.0;
+	FString LoadingMapName;
+	bool bWaitingForControllable = true;
+
+	void OnPreloadComplete();
+	void OnPreLoadMap(const FString& MapName);
+};
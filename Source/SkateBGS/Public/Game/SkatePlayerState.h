@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerState.h"
+#include "SkatePlayerState.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnRingProgressChanged, int32 /*OldRingIndex*/, int32 /*NewRingIndex*/);
+
+/**
+ * Per player course progress. Rings are taken in order, so the index of the next ring is the whole
+ * state: one push model int per player however long the course is. The server advances it after
+ * validating collection, clients derive which rings are collected, current and next from it.
+ */
+UCLASS()
+class SKATEBGS_API ASkatePlayerState : public APlayerState
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	int32 GetRingIndex() const { return RingIndex; }
+
+	/** Server only, sets the next ring the player has to take */
+	void SetRingIndex(int32 NewRingIndex);
+
+	/** Broadcast on the server when the index is set and on clients when it replicates */
+	FOnRingProgressChanged OnRingProgressChanged;
+
+private:
+	UPROPERTY(ReplicatedUsing = OnRep_RingIndex)
+	int32 RingIndex = 0;
+
+	UFUNCTION()
+	void OnRep_RingIndex(int32 OldRingIndex);
+};
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/** One sample of a run, everything a ghost needs to look like the skater */
+struct FGhostFrame
+{
+	float Time = 0.f;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FRotator SkateRotation = FRotator::ZeroRotator;
+	float Speed = 0.f;
+	bool bIsFalling = false;
+	bool bIsSpeedingUp = false;
+	bool bIsFlipping = false;
+
+	static FGhostFrame Lerp(const FGhostFrame& A, const FGhostFrame& B, float Alpha);
+};
+
+/**
+ * Quantized, delta encoded ghost stream. Every value is quantized (location to 0.1 units, angles to
+ * 16 bits, speed to whole units, time to ms) and stored as a zigzag varint delta against the
+ * previous quantized value, so values never drift and a steady skater costs a few bytes a frame.
+ */
+struct FGhostQuantizedFrame
+{
+	int32 TimeMs = 0;
+	FIntVector Location = FIntVector::ZeroValue;
+	uint16 Rotation[3] = {};
+	uint16 SkateRotation[3] = {};
+	int32 Speed = 0;
+	uint8 Flags = 0;
+
+	static FGhostQuantizedFrame Quantize(const FGhostFrame& Frame);
+	FGhostFrame Dequantize() const;
+};
+
+/** Streams a run to disk while it's being skated, the file is only kept if it beats the saved best time */
+class SKATEBGS_API FGhostWriter
+{
+public:
+	~FGhostWriter();
+
+	bool Begin(const FString& InFinalPath);
+	void AddFrame(const FGhostFrame& Frame);
+
+	/** Closes the stream and replaces the saved ghost if RunTime beats it, returns whether it did */
+	bool Finish(float RunTime);
+
+	/** Throws the run away */
+	void Discard();
+
+	bool IsRecording() const { return File != nullptr; }
+
+private:
+	IFileHandle* File = nullptr;
+	FString FinalPath;
+	FString TempPath;
+	TArray<uint8> Buffer;
+	FGhostQuantizedFrame Previous;
+	uint32 NumFrames = 0;
+
+	void Flush();
+};
+
+/** Decodes a ghost file incrementally through a fixed size window, so memory doesn't grow with run length */
+class SKATEBGS_API FGhostReader
+{
+public:
+	~FGhostReader();
+
+	bool Open(const FString& Path);
+	void Close();
+
+	/** Decodes the next frame, false at the end of the run */
+	bool ReadFrame(FGhostFrame& OutFrame);
+
+	float GetRunTime() const { return RunTime; }
+
+	/** Reads only the header, FLT_MAX when there is no ghost */
+	static float ReadRunTime(const FString& Path);
+
+private:
+	IFileHandle* File = nullptr;
+	TArray<uint8> Window;
+	int32 WindowPos = 0;
+	int32 WindowEnd = 0;
+	int64 FileRemaining = 0;
+	FGhostQuantizedFrame Previous;
+	uint32 NumFrames = 0;
+	uint32 FramesRead = 0;
+	float RunTime = 0.f;
+
+	void Refill();
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Ghost/GhostRecording.h"
+#include "SkateGhost.generated.h"
+
+/**
+ * Plays back a recorded best run. Only moves its meshes: no traces, no movement component and no collision.
+ * The animation Blueprint reads Speed and the state flags below.
+ */
+UCLASS()
+class SKATEBGS_API ASkateGhost : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	ASkateGhost();
+
+	virtual void Tick(float DeltaTime) override;
+
+	/** Starts streaming the ghost file from its first frame */
+	bool StartPlayback(const FString& Path);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	USkeletalMeshComponent* Body;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UStaticMeshComponent* SkateMesh;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, category = "Animation")
+	float Speed = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, category = "Animation")
+	bool bIsFalling = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, category = "Animation")
+	bool bIsSpeedingUp = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, category = "Animation")
+	bool bIsFlipping = false;
+
+private:
+	FGhostReader Reader;
+	FGhostFrame FromFrame;
+	FGhostFrame ToFrame;
+	float PlaybackTime = 0.f;
+	bool bHasMoreFrames = false;
+
+	void ApplyFrame(const FGhostFrame& Frame);
+};
@@ -6,6 +6,15 @@
 #include "GameFramework/Actor.h"
 #include "Ring.generated.h"
 
+/** How much of its VFX a ring runs, set by ARingManager's significance pass */
+enum class ERingEffectLevel : uint8
+{
+	Off,
+	Paused,
+	Reduced,
+	Full
+};
+
 UCLASS()
 class SKATEBGS_API ARing : public AActor
 {
@@ -19,12 +28,29 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	virtual void Tick(float DeltaTime) override;
+
+#if WITH_EDITOR
+	virtual void PostEditMove(bool bFinished) override;
+#endif
+
+	//The bob can be done by the ring material's World Position Offset, reading these from Custom Primitive Data:
+	//0 = time offset, 1 = Amplitude, 2 = Period. Z = Amplitude * sin((Time + time offset) * Period)
+	/** Set once the ring material reads the bob from Custom Primitive Data, until then the ring ticks and moves itself */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sine Parameters")
+	bool bBobInMaterial = false;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sine Parameters");
-	float Amplitude = 0.25f; //This is initialization, most efficient
+	float Amplitude = 36.f; //Height of the bob in units, matches the old per frame offset of 3 at 60 fps
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sine Parameters");
 	float Period = 5.f; // period = 2pi/K (How long it takes to do a wave, 0 to 1)
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sine Parameters");
+	float TimeOffset = 0.f; //Added to a phase picked from the ring's location, so rings never bob in sync
+
 	UPROPERTY(EditAnywhere)
 	class UNiagaraComponent* VFX;
 
@@ -34,22 +60,12 @@ protected:
 	UPROPERTY(EditAnywhere)
 	USoundBase* OverlapSound;
 
-	float TransformedSin();
-
-	float TransformedCosin();
-
-	UFUNCTION()
-	virtual void OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-	UFUNCTION()
-	virtual void OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	UStaticMeshComponent* Mesh;
 
+	/** Only used for its radius, collection is detected by ARingManager so this has no collision */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	class USphereComponent* Sphere;
 
@@ -62,7 +78,38 @@ public:
 	void SetRingInactive();
 	void SetRingActive();
 
+	/** Plays the pickup effects and gives the ring to the player, called by ARingManager */
+	void Collect(class ASkateCharacter* Player);
+
+	float GetCollectRadius() const;
+
+	/** Hides the ring, turns off its collision and VFX so the manager can pool it instead of destroying it */
+	void SetRingCollected();
+
+	/** Brings a collected ring back so the course can be re-armed in place */
+	void ResetRing();
+
+	bool IsCollected() const { return bIsCollected; }
+
+	/** Runs, scales down, freezes or stops the VFX. Collected rings stay off */
+	void SetEffectLevel(ERingEffectLevel Level);
+
+	/** Niagara user parameter multiplying the spawn rate, set to ReducedSpawnRateScale at the Reduced level */
+	UPROPERTY(EditAnywhere, Category = "Significance")
+	FName SpawnRateScaleParameter = FName("User.SpawnRateScale");
+
+	UPROPERTY(EditAnywhere, Category = "Significance")
+	float ReducedSpawnRateScale = 0.25f;
+
 private:
-	float RunningTime;
+	bool bIsCollected = false;
+	ERingEffectLevel EffectLevel = ERingEffectLevel::Full;
+
+	float GetBobTimeOffset() const;
+	bool ShouldTickBob() const;
+
+	//Where the ticking bob is measured from, and its phase
+	FVector BobBaseLocation = FVector::ZeroVector;
+	float BobTimeOffset = 0.f;
 
 };
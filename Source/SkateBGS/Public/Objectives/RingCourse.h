@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "RingCourse.generated.h"
+
+USTRUCT(BlueprintType)
+struct FRingCourseEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float Radius = 100.f;
+
+	//Phase of the material bob so rings don't have to move in sync
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float TimeOffset = 0.f;
+};
+
+/**
+ * A ring course as plain data, in the order the rings have to be collected.
+ * ARingManager renders its visible rings as instances instead of one ARing actor per ring.
+ */
+UCLASS(BlueprintType)
+class SKATEBGS_API URingCourse : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TArray<FRingCourseEntry> Rings;
+};
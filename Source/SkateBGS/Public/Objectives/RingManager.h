@@ -5,10 +5,25 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Ring.h"
+#include "Objectives/RingSpatialGrid.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
 #include "RingManager.generated.h"
 
+class URingCourse;
+class UInstancedStaticMeshComponent;
+class ASkatePlayerState;
+
+/**
+ * Runs the ring course. The server validates collection for every player and advances their
+ * ASkatePlayerState, each machine then shows the rings for its own local player from that progress.
+ * Neither the manager nor the rings replicate.
+ *
+ * Hand placed rings are soft references, detection runs on locations cached in the editor so rings
+ * only need to be loaded to be seen. With World Partition the manager streams in the cells around
+ * the next rings of the course and applies the ring state when each ring streams in.
+ */
 UCLASS()
-class SKATEBGS_API ARingManager : public AActor
+class SKATEBGS_API ARingManager : public AActor, public IWorldPartitionStreamingSourceProvider
 {
 	GENERATED_BODY()
 	
@@ -20,20 +35,155 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#endif
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/** Hand placed rings in course order, only used when there is no Course. Rings may be streamed out */
 	UPROPERTY(EditAnywhere)
-	TArray<ARing*> RingArray;
+	TArray<TSoftObjectPtr<ARing>> RingArray;
+
+	/** Location and radius of every RingArray entry, refreshed in the editor from the loaded rings */
+	UPROPERTY(VisibleAnywhere, Category = "Streaming")
+	TArray<FVector> RingLocations;
+
+	UPROPERTY(VisibleAnywhere, Category = "Streaming")
+	TArray<float> RingRadii;
+
+	/** How many rings from the player's next one keep their cells streamed in */
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	int32 RingsStreamedAhead = 3;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	float RingStreamingRadius = 2000.f;
+
+	/** Called by rings as they begin play, applies their current state when they stream in */
+	void OnRingLoaded(ARing* Ring);
+
+#if WITH_EDITOR
+	/** Called by rings moved in the editor, keeps their cached location current without reconstructing the manager */
+	void OnRingMoved(ARing* Ring);
+#endif
+
+	virtual bool GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const override;
+	virtual const UObject* GetStreamingSourceOwner() const override { return this; }
+
+	/** Data only course rendered through RingInstances, takes priority over RingArray */
+	UPROPERTY(EditAnywhere, Category = "Course")
+	URingCourse* Course;
+
+	//Only the visible rings have instances, the upcoming ring here and the active one in ActiveRingInstances.
+	//Per instance custom data 0 is the TimeOffset of the ring
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Course")
+	UInstancedStaticMeshComponent* RingInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Course")
+	UInstancedStaticMeshComponent* ActiveRingInstances;
+
+	/** Materials of the course rings, same as ARing's OnMaterial and OffMaterial */
+	UPROPERTY(EditAnywhere, Category = "Course")
+	class UMaterialInterface* ActiveRingMaterial;
+
+	UPROPERTY(EditAnywhere, Category = "Course")
+	class UMaterialInterface* UpcomingRingMaterial;
+
+	/** Bob of the visible course rings, same as ARing's Amplitude and Period. 0 turns it off */
+	UPROPERTY(EditAnywhere, Category = "Course")
+	float CourseBobAmplitude = 36.f;
+
+	UPROPERTY(EditAnywhere, Category = "Course")
+	float CourseBobPeriod = 5.f;
+
+	UPROPERTY(EditAnywhere, Category = "Course")
+	class UNiagaraSystem* OverlapEffect;
+
+	UPROPERTY(EditAnywhere, Category = "Course")
+	USoundBase* OverlapSound;
 
 	class ASkateCharacter* PlayerRef;
 
 	UFUNCTION()
 	void SetNextRing();
 
+	/** Rings further than this from the player run their VFX at a reduced spawn rate */
+	UPROPERTY(EditAnywhere, Category = "Significance")
+	float FullEffectDistance = 3000.f;
+
+	/** Rings over the skate.Rings.MaxActiveVFX budget but closer than this are paused instead of stopped */
+	UPROPERTY(EditAnywhere, Category = "Significance")
+	float PausedEffectDistance = 6000.f;
+
+	/** Re-arms every collected ring and restarts the course from the first ring, nothing is spawned or destroyed.
+	 *  With a skate player state only the server can reset, clients follow the replicated progress. */
+	UFUNCTION(BlueprintCallable)
+	void ResetCourse();
+
 private:
+	enum class ERingState : uint8
+	{
+		Hidden,
+		Upcoming,
+		Active,
+		Collected
+	};
+
 	int32 RingIndex = 0;
+	ARing* GetRing(int32 Index) const;
+	void CacheRingLocations();
+
+	/** Logs every ring that has never been cached, they can't be collected until they stream in */
+	bool ValidateRingCache() const;
+	bool IsRingCached(int32 Index) const;
 	void InitializeRings();
+	void SetRingState(int32 Index, ERingState State);
+	void CollectRing(int32 Index);
+	bool UsesCourse() const;
+	int32 NumRings() const;
+
+	//Ring collection is a swept segment test against this grid, rings have no physics bodies
+	FRingSpatialGrid RingGrid;
+	TBitArray<> CollectedRings;
+	FVector LastPlayerLocation = FVector::ZeroVector;
+	bool bHasLastPlayerLocation = false;
+	void BuildRingGrid();
+	void BuildRingInstances();
+
+	//RingArray index by ring name, so a ring streaming in finds its entry without a search
+	TMap<FName, int32> RingIndices;
+	void BuildRingIndices();
+
+	//Set when a ring streamed in with an uncached location, the grid is rebuilt once in the next Tick
+	bool bRingGridDirty = false;
+
+	//Course rings that currently have an instance, everything else isn't drawn at all
+	TArray<int32> ActiveCourseRings;
+	TArray<int32> UpcomingCourseRings;
+	void UpdateCourseInstances();
+	void DetectCollection();
+	int32 SweepForRing(const ASkateCharacter* Skater, const FVector& SegmentStart, int32 NextRingIndex) const;
+	void ResetRings();
+
+	//Progress of the local player, the rings on this machine follow it
+	UPROPERTY(Transient)
+	ASkatePlayerState* LocalPlayerState;
+	void BindLocalPlayer();
+	void SetPlayerRef(ASkateCharacter* Player);
+	void OnLocalRingProgress(int32 OldRingIndex, int32 NewRingIndex);
+
+	//Server side sweep start for every skater with a player state
+	TMap<TWeakObjectPtr<const AActor>, FVector> LastSkaterLocations;
+
+	//Ranks hand placed rings by course order and distance and hands out the VFX budget
+	FTimerHandle SignificanceTimer;
+	TArray<TPair<float, int32>> SignificanceOrder;
+	void UpdateSignificance();
 
 };
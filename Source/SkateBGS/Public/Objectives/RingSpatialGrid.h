@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Ring centres and radii stored as flat arrays plus a uniform XY grid over them.
+ * Used by ARingManager to find which ring a skater's swept segment passed through this frame.
+ */
+class SKATEBGS_API FRingSpatialGrid
+{
+public:
+	void Reset();
+
+	/** Adds a ring and returns its index, which matches the order rings were added in */
+	int32 AddRing(const FVector& Center, float Radius);
+
+	/** Buckets the rings into cells, call after all rings are added */
+	void Build(float MinCellSize = 500.f);
+
+	/**
+	 * Returns the first ring (lowest index) accepted by Filter whose sphere, grown by ExtraRadius,
+	 * touches the segment Start-End. INDEX_NONE if there is none.
+	 */
+	int32 FindRing(const FVector& Start, const FVector& End, float ExtraRadius, TFunctionRef<bool(int32)> Filter) const;
+
+	int32 Num() const { return Centers.Num(); }
+	const FVector& GetCenter(int32 Index) const { return Centers[Index]; }
+	float GetRadius(int32 Index) const { return Radii[Index]; }
+
+private:
+	TArray<FVector> Centers;
+	TArray<float> Radii;
+
+	//Cell (X, Y) owns CellRings[CellStarts[Cell] .. CellStarts[Cell + 1])
+	TArray<int32> CellStarts;
+	TArray<int32> CellRings;
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	float CellSize = 1.f;
+	float MaxRadius = 0.f;
+	int32 CellsX = 0;
+	int32 CellsY = 0;
+
+	FIntPoint GetCell(const FVector2D& Location) const;
+};
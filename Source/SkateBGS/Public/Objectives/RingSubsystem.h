@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RingSubsystem.generated.h"
+
+class ARingManager;
+
+/**
+ * Knows the world's ring manager, so rings streaming in find it without searching every actor.
+ * The manager registers itself from BeginPlay to EndPlay.
+ */
+UCLASS()
+class SKATEBGS_API URingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	void RegisterManager(ARingManager* Manager);
+	void UnregisterManager(ARingManager* Manager);
+
+	/** The manager that has begun play, null before that or when the world has none */
+	ARingManager* GetManager() const { return Manager.Get(); }
+
+private:
+	TWeakObjectPtr<ARingManager> Manager;
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "Benchmark/SkateBenchmark.h"
+
+DECLARE_STATS_GROUP(TEXT("SkateBGS"), STATGROUP_SkateBGS, STATCAT_Advanced);
+
+/** Cycle stat in stat SkateBGS with a benchmark probe of the same name, declare in the .cpp that scopes it */
+#define DECLARE_SKATE_CYCLE_STAT(CounterName, StatId) \
+	DECLARE_CYCLE_STAT(CounterName, StatId, STATGROUP_SkateBGS); \
+	static FSkateProbe StatId##_Probe(CounterName)
+
+/** Cycle counter for stat SkateBGS, a matching CPU event for Unreal Insights and the benchmark probe */
+#define SKATE_SCOPE_CYCLE_COUNTER(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat); \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	FSkateProbeScope ANONYMOUS_VARIABLE(SkateProbeScope)(Stat##_Probe)
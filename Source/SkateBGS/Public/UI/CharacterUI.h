@@ -7,7 +7,8 @@
 #include "CharacterUI.generated.h"
 
 /**
- * 
+ * Gameplay HUD. Setters are cheap to call every frame: they skip widgets whose value didn't change
+ * and reuse cached text, so Slate only invalidates what actually changed.
  */
 UCLASS()
 class SKATEBGS_API UCharacterUI : public UUserWidget
@@ -18,6 +19,9 @@ public:
 	void SetStaminaPercent(float Percent);
 	void UpdateRingCount(int32 Rings);
 	void UpdateTimer(int32 Minutes, int32 Seconds);
+
+protected:
+	virtual void NativeOnInitialized() override;
 	
 private:
 	UPROPERTY(meta = (BindWidget))
@@ -28,4 +32,19 @@ private:
 
 	UPROPERTY(meta = (BindWidget))
 	UTextBlock* Timer;
+
+	/** Wrap the HUD in an Invalidation Box with this name so its layout and paint are cached between changes */
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UInvalidationBox* HUDInvalidationBox;
+
+	//Preformatted "0".."99" so ring count updates don't format or allocate
+	TArray<FText> CountText;
+
+	//Preformatted "00:00".."09:59" indexed by total seconds, so the timer doesn't format or allocate either
+	TArray<FText> TimerText;
+
+	float DisplayedStaminaPercent = -1.f;
+	int32 DisplayedRings = INDEX_NONE;
+	int32 DisplayedMinutes = INDEX_NONE;
+	int32 DisplayedSeconds = INDEX_NONE;
 };
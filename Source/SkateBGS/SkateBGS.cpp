@@ -1,7 +1,10 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SkateBGS.h"
+#include "SkateBGSLog.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogSkateBGS);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, SkateBGS, "SkateBGS" );
  
\ No newline at end of file
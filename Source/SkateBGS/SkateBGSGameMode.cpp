@@ -2,6 +2,7 @@
 
 #include "SkateBGSGameMode.h"
 #include "SkateBGSCharacter.h"
+#include "Game/SkatePlayerState.h"
 #include "UObject/ConstructorHelpers.h"
 
 ASkateBGSGameMode::ASkateBGSGameMode()
@@ -12,4 +13,7 @@ ASkateBGSGameMode::ASkateBGSGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	// ring course progress is replicated per player
+	PlayerStateClass = ASkatePlayerState::StaticClass();
 }